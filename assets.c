@@ -0,0 +1,222 @@
+#include "assets.h"
+
+#include <fcntl.h>      /* open */
+#include <stdio.h>      /* fprintf */
+#include <string.h>     /* memcmp, strcmp */
+#include <sys/mman.h>   /* mmap, munmap */
+#include <sys/stat.h>   /* fstat */
+#include <unistd.h>     /* close */
+
+#include "timer.h"
+
+AssetPack *OpenAssetPack(const char *path) {
+    struct stat st;
+    const AssetPackHeader *h;
+    AssetPack *pack;
+    const char *base;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(AssetPackHeader)) {
+        fprintf(stderr, "Asset pack too small: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Could not map asset pack: %s\n", path);
+        return NULL;
+    }
+    h = (const AssetPackHeader *) base;
+
+    if (memcmp(h->magic, ASSET_PACK_MAGIC, 4) != 0
+        || h->version != ASSET_PACK_VERSION
+        || h->entry_size != sizeof(AssetEntry)
+        || sizeof(AssetPackHeader) + (uint64_t) h->count * sizeof(AssetEntry) > (uint64_t) st.st_size) {
+        fprintf(stderr, "Asset pack has the wrong version: %s\n", path);
+        munmap((void *) base, st.st_size);
+        return NULL;
+    }
+
+    pack = MemAlloc(sizeof(AssetPack));
+    *pack = (AssetPack){
+        .base = base,
+        .size = st.st_size,
+        .header = h,
+        .entries = (const AssetEntry *) (base + sizeof(AssetPackHeader)),
+    };
+    return pack;
+}
+
+void CloseAssetPack(AssetPack *pack) {
+    if (pack == NULL) {
+        return;
+    }
+    munmap((void *) pack->base, pack->size);
+    MemFree(pack);
+}
+
+const AssetEntry *FindAsset(AssetPack *pack, const char *name) {
+    const AssetEntry *e;
+
+    if (strncmp(name, "./", 2) == 0) {
+        name += 2;
+    }
+    /* a handful of assets, a linear search is fine */
+    for (uint32_t i = 0; i < pack->header->count; i++) {
+        e = &pack->entries[i];
+        if (strncmp(e->name, name, ASSET_NAME_MAX) == 0) {
+            /* don't trust the offsets further than the mapping */
+            if (e->offset % ASSET_PACK_ALIGN != 0 || e->offset + e->size > pack->size) {
+                fprintf(stderr, "Asset pack entry is corrupt: %s\n", name);
+                return NULL;
+            }
+            return e;
+        }
+    }
+    return NULL;
+}
+
+bool PackedImage(AssetPack *pack, const char *name, Image *out) {
+    const AssetEntry *e;
+
+    if (pack == NULL || (e = FindAsset(pack, name)) == NULL) {
+        return false;
+    }
+    if (e->size < (uint64_t) GetPixelDataSize(e->width, e->height, e->format)) {
+        fprintf(stderr, "Asset pack entry is truncated: %s\n", name);
+        return false;
+    }
+
+    *out = (Image){
+        .data = (void *) (pack->base + e->offset),
+        .width = e->width,
+        .height = e->height,
+        .mipmaps = e->mipmaps,
+        .format = e->format,
+    };
+    return true;
+}
+
+/* loader thread: takes jobs off todo, decodes them, puts them on done */
+static void *loader_main(void *arg) {
+    AssetLoader *l = arg;
+    AssetJob job;
+
+    pthread_mutex_lock(&l->lock);
+    for (;;) {
+        while (l->todo.length == 0 && !l->stop) {
+            pthread_cond_wait(&l->cond, &l->lock);
+        }
+        if (l->stop) {
+            break;
+        }
+        job = vec_pop(&l->todo);
+        pthread_mutex_unlock(&l->lock);
+
+        /* the slow part, without the lock */
+        job.packed = PackedImage(l->pack, job.texture->filepath, &job.image);
+        if (!job.packed) {
+            job.image = LoadImage(job.texture->filepath);
+        }
+
+        pthread_mutex_lock(&l->lock);
+        vec_push(&l->done, job);
+    }
+    pthread_mutex_unlock(&l->lock);
+    return NULL;
+}
+
+AssetLoader *StartAssetLoader(AssetPack *pack) {
+    AssetLoader *l = MemAlloc(sizeof(AssetLoader));
+
+    l->pack = pack;
+    vec_init(&l->todo);
+    vec_init(&l->done);
+    pthread_mutex_init(&l->lock, NULL);
+    pthread_cond_init(&l->cond, NULL);
+    l->started = ClockSeconds();
+    pthread_create(&l->thread, NULL, loader_main, l);
+    return l;
+}
+
+void StopAssetLoader(AssetLoader *l) {
+    if (l == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&l->lock);
+    l->stop = true;
+    pthread_cond_signal(&l->cond);
+    pthread_mutex_unlock(&l->lock);
+    pthread_join(l->thread, NULL);
+
+    /* decoded but never uploaded */
+    for (int i = 0; i < l->done.length; i++) {
+        if (!l->done.data[i].packed) {
+            UnloadImage(l->done.data[i].image);
+        }
+    }
+    vec_deinit(&l->todo);
+    vec_deinit(&l->done);
+    pthread_mutex_destroy(&l->lock);
+    pthread_cond_destroy(&l->cond);
+    CloseAssetPack(l->pack);
+    MemFree(l);
+}
+
+void RequestTexture(AssetLoader *l, GameTexture *t) {
+    pthread_mutex_lock(&l->lock);
+    vec_insert(&l->todo, 0, ((AssetJob){ .texture = t }));
+    pthread_cond_signal(&l->cond);
+    pthread_mutex_unlock(&l->lock);
+    l->pending++;
+}
+
+bool PumpAssetUploads(AssetLoader *l, int max) {
+    AssetJob jobs[ASSET_UPLOADS_PER_FRAME];
+    int n = 0;
+    bool ok = true;
+
+    if (l == NULL || l->pending == 0) {
+        return true;
+    }
+    if (max > ASSET_UPLOADS_PER_FRAME) {
+        max = ASSET_UPLOADS_PER_FRAME;
+    }
+
+    /* only hold the lock long enough to grab them */
+    pthread_mutex_lock(&l->lock);
+    while (n < max && l->done.length > 0) {
+        jobs[n++] = vec_pop(&l->done);
+    }
+    pthread_mutex_unlock(&l->lock);
+
+    for (int i = 0; i < n; i++) {
+        if (jobs[i].image.data == NULL) {
+            fprintf(stderr, "Could not load texture: %s\n", jobs[i].texture->filepath);
+            jobs[i].texture->failed = true;
+            ok = false;
+        } else {
+            jobs[i].texture->data = LoadTextureFromImage(jobs[i].image);
+            jobs[i].texture->loaded = true;
+            if (!jobs[i].packed) {
+                UnloadImage(jobs[i].image);
+            }
+        }
+        l->pending--;
+    }
+
+    if (l->pending == 0) {
+        l->finished = ClockSeconds();
+    }
+    return ok;
+}
+
+bool AssetsLoaded(AssetLoader *l) {
+    return l != NULL && l->pending == 0;
+}
@@ -0,0 +1,116 @@
+#ifndef _ASSETS_H_
+#define _ASSETS_H_
+
+#include <pthread.h>    /* pthread_t, pthread_mutex_t, pthread_cond_t */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raylib.h"
+#include "vec.h"
+
+/*
+    packed asset archive, written offline by utils/assetpack.c.
+
+    every image under assets/ is decoded once at pack time and stored as
+    raw pixels in the format the GPU takes, so loading is mmap + one
+    upload per texture straight out of the mapping (no PNG decode, no
+    copy).
+
+    layout: [AssetPackHeader][AssetEntry * count][pad][pixel blobs...]
+    blobs start on ASSET_PACK_ALIGN boundaries.
+
+    bump ASSET_PACK_VERSION whenever the header or entries change.
+
+    loading is asynchronous: RequestTexture queues a GameTexture for the
+    loader thread, which decodes it (or just finds it in the pack), and
+    PumpAssetUploads moves a few finished ones onto the GPU every frame on
+    the main thread, which is the only one allowed to touch GL.
+*/
+
+#define ASSET_PACK_MAGIC "MSAP"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGN 64
+#define ASSET_PACK_DEFAULT_PATH "./build/assets.pack"
+#define ASSET_NAME_MAX 96
+/* GPU uploads per frame, so a big batch doesn't stall one frame */
+#define ASSET_UPLOADS_PER_FRAME 2
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t entry_size;
+} AssetPackHeader;
+
+typedef struct {
+    /* path as the game asks for it, without a leading ./ */
+    char name[ASSET_NAME_MAX];
+    int32_t width, height;
+    /* raylib PixelFormat */
+    int32_t format;
+    int32_t mipmaps;
+    uint64_t offset;
+    uint64_t size;
+} AssetEntry;
+
+typedef struct {
+    const char *base;
+    size_t size;
+    const AssetPackHeader *header;
+    const AssetEntry *entries;
+} AssetPack;
+
+typedef struct {
+    bool loaded;
+    /* the loader couldn't decode it, it won't be asked for again */
+    bool failed;
+    const char *filepath;
+    Texture2D data;
+} GameTexture;
+
+typedef struct {
+    /* main thread only */
+    GameTexture *texture;
+    /* filled in by the loader thread */
+    Image image;
+    /* image.data points into the pack's mapping, don't free it */
+    bool packed;
+} AssetJob;
+
+typedef vec_t(AssetJob) AssetJobVec;
+
+typedef struct {
+    /* may be NULL, then everything is decoded from its file */
+    AssetPack *pack;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    /* guarded by lock */
+    AssetJobVec todo, done;
+    bool stop;
+
+    /* main thread only */
+    int pending;
+    double started, finished;
+} AssetLoader;
+
+/* NULL if the file is missing or not a pack */
+AssetPack *OpenAssetPack(const char *path);
+void CloseAssetPack(AssetPack*);
+
+const AssetEntry *FindAsset(AssetPack*, const char *name);
+/* an Image pointing into the mapping, false if it isn't in the pack */
+bool PackedImage(AssetPack*, const char *name, Image *out);
+
+/* takes ownership of the pack */
+AssetLoader *StartAssetLoader(AssetPack*);
+void StopAssetLoader(AssetLoader*);
+void RequestTexture(AssetLoader*, GameTexture*);
+/* main thread, uploads up to max finished textures. false if one of them
+   couldn't be loaded at all, that one is logged and marked failed */
+bool PumpAssetUploads(AssetLoader*, int max);
+/* true once everything requested so far is on the GPU */
+bool AssetsLoaded(AssetLoader*);
+
+#endif /* _ASSETS_H_ */
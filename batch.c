@@ -0,0 +1,99 @@
+#include "batch.h"
+
+#include <pthread.h>    /* pthread_create, pthread_join */
+#include <stdatomic.h>  /* atomic_int */
+
+typedef struct {
+    BatchConfig config;
+    MatchResult *results;
+    /* index of the next match nobody has claimed yet */
+    atomic_int next;
+} BatchJob;
+
+static int total_entities(Game *game) {
+    int n = 0;
+    for (int i = 0; i < E_COUNT; i++) {
+        n += game->entities[i].length;
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        n += game->particles[i].length;
+    }
+    return n;
+}
+
+void RunMatch(MatchResult *r, unsigned int seed, int max_ticks, bool autopilot) {
+    /* too big to want several of these on a worker's stack */
+    Game *game = MemAlloc(sizeof(Game));
+    double start = ClockSeconds();
+    int n;
+
+    InitGameHeadless(game, seed);
+    game->autopilot = autopilot;
+    *r = (MatchResult){ .seed = seed };
+
+    while (r->ticks < max_ticks && game->state == GS_GAMEPLAY) {
+        GameTick(game);
+        r->ticks++;
+        if ((n = total_entities(game)) > r->peak_entities) {
+            r->peak_entities = n;
+        }
+    }
+
+    r->survived = game->ui.gametime;
+    r->died = game->state == GS_GAMEOVER;
+    r->wall_secs = ClockSeconds() - start;
+
+    DestroyGameContext(game);
+    MemFree(game);
+}
+
+static void *batch_worker(void *arg) {
+    BatchJob *job = arg;
+    int i;
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->config.matches) {
+        RunMatch(&job->results[i], job->config.seed + i, job->config.max_ticks, job->config.autopilot);
+    }
+    return NULL;
+}
+
+void RunBatch(BatchConfig config) {
+    BatchJob job = { .config = config };
+    pthread_t *threads;
+    long total_ticks = 0;
+    double start, wall;
+
+    if (config.matches <= 0) {
+        return;
+    }
+    if (config.threads <= 0) {
+        config.threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (config.threads > config.matches) {
+        config.threads = config.matches;
+    }
+
+    job.config = config;
+    job.results = MemAlloc(config.matches * sizeof(MatchResult));
+    atomic_init(&job.next, 0);
+    threads = MemAlloc(config.threads * sizeof(pthread_t));
+
+    start = ClockSeconds();
+    for (int i = 0; i < config.threads; i++) {
+        pthread_create(&threads[i], NULL, batch_worker, &job);
+    }
+    for (int i = 0; i < config.threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    wall = ClockSeconds() - start;
+
+    printf("match\tseed\tticks\tsurvived\tdied\tpeak\twall\n");
+    for (int i = 0; i < config.matches; i++) {
+        MatchResult *r = &job.results[i];
+        printf("%d\t%u\t%d\t%.2f\t%d\t%d\t%.3f\n", i, r->seed, r->ticks, r->survived, r->died, r->peak_entities, r->wall_secs);
+        total_ticks += r->ticks;
+    }
+    printf("%d matches on %d threads in %.3fs (%.0f ticks/s)\n", config.matches, config.threads, wall, total_ticks / wall);
+
+    MemFree(threads);
+    MemFree(job.results);
+}
@@ -0,0 +1,41 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include "game.h"
+
+/* runs lots of independent headless matches across worker threads */
+
+typedef struct {
+    int matches;
+    /* per match, a match also ends when the player dies */
+    int max_ticks;
+    /* 0 = one per core */
+    int threads;
+    /* match i is seeded with seed + i */
+    unsigned int seed;
+    /* let the bot play, otherwise the player stands still */
+    bool autopilot;
+} BatchConfig;
+
+typedef struct {
+    unsigned int seed;
+    int ticks;
+    float survived;
+    bool died;
+    int peak_entities;
+    double wall_secs;
+} MatchResult;
+
+#define DEFAULT_BATCH_CONFIG        \
+    (BatchConfig){                  \
+        .matches = 0,               \
+        .max_ticks = 60 * 60 * 10,  \
+        .threads = 0,               \
+        .seed = 1,                  \
+        .autopilot = false,         \
+    }
+
+void RunMatch(MatchResult*, unsigned int seed, int max_ticks, bool autopilot);
+void RunBatch(BatchConfig);
+
+#endif /* _BATCH_H_ */
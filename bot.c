@@ -0,0 +1,83 @@
+#include "bot.h"
+#include "game.h"
+
+/* 8 directions, counterclockwise from +x (y points down) */
+static const int octant_dirs[8][2] = {
+    { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 },
+    { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 },
+};
+
+static void BotThink(Game *game) {
+    Bot *bot = &game->bot;
+    Entity *player = &game->player;
+    Vector2 size = screensize(game);
+    Vector2 flee = { 0, 0 };
+    EntityVec *ev;
+    Entity *e;
+    float dx, dy, d2, w;
+    int cx, cy, best;
+
+    /* count and position sums per aim cell */
+    int counts[BOT_AIM_CELLS * BOT_AIM_CELLS] = {0};
+    Vector2 sums[BOT_AIM_CELLS * BOT_AIM_CELLS] = {0};
+
+    for (int t = 0; t < len(game->config.enemy_types); t++) {
+        ev = &game->entities[game->config.enemy_types[t]];
+        for (int i = 0; i < ev->length; i++) {
+            e = &ev->data[i];
+            dx = player->x - e->x;
+            dy = player->y - e->y;
+            d2 = dx * dx + dy * dy;
+
+            if (d2 < BOT_DANGER_RADIUS * BOT_DANGER_RADIUS) {
+                /* closer and harder hitting = scarier, 1/d^2 falloff on a unit vector */
+                w = e->contact_damage / ((d2 + 1.0f) * sqrtf(d2 + 1.0f));
+                flee.x += dx * w;
+                flee.y += dy * w;
+            }
+
+            cx = (e->x - (player->x - size.x / 2)) * BOT_AIM_CELLS / size.x;
+            cy = (e->y - (player->y - size.y / 2)) * BOT_AIM_CELLS / size.y;
+            if (0 <= cx && cx < BOT_AIM_CELLS && 0 <= cy && cy < BOT_AIM_CELLS) {
+                counts[cy * BOT_AIM_CELLS + cx]++;
+                sums[cy * BOT_AIM_CELLS + cx].x += e->x;
+                sums[cy * BOT_AIM_CELLS + cx].y += e->y;
+            }
+        }
+    }
+
+    /* movement */
+    bot->move_x = 0;
+    bot->move_y = 0;
+    if (flee.x != 0 || flee.y != 0) {
+        float angle = atan2f(flee.y + BOT_STRAFE * flee.x, flee.x - BOT_STRAFE * flee.y);
+        int octant = ((int) lroundf(angle / (PI / 4)) + 8) % 8;
+        bot->move_x = octant_dirs[octant][0];
+        bot->move_y = octant_dirs[octant][1];
+    }
+
+    /* aiming */
+    best = -1;
+    for (int i = 0; i < BOT_AIM_CELLS * BOT_AIM_CELLS; i++) {
+        if (counts[i] > 0 && (best == -1 || counts[i] > counts[best])) {
+            best = i;
+        }
+    }
+    if (best != -1) {
+        bot->aim = (Vector2){ sums[best].x / counts[best], sums[best].y / counts[best] };
+    }
+}
+
+void UpdateBot(Game *game) {
+    Bot *bot = &game->bot;
+
+    if (bot->cooldown <= 0) {
+        BotThink(game);
+        bot->cooldown = BOT_THINK_TICKS;
+    }
+    bot->cooldown--;
+
+    game->input.move_x = bot->move_x;
+    game->input.move_y = bot->move_y;
+    game->input.aim = bot->aim;
+}
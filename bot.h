@@ -0,0 +1,36 @@
+#ifndef _BOT_H_
+#define _BOT_H_
+
+#include "raylib.h"
+
+/*
+    autopilot for load testing. it fills in game->input the same way
+    HandleInput does, so movement and aiming go through the normal
+    MovePlayer and weapon paths.
+
+    it thinks every BOT_THINK_TICKS ticks with one pass over the enemies:
+    - runs away from the weighted enemy density near the player, with a
+      sideways bias so it circles (kites) instead of running into spawns
+    - aims at the busiest cell of a coarse grid over the screen
+*/
+
+typedef struct Game Game;
+
+#define BOT_THINK_TICKS 4
+/* enemies further than this don't scare the bot */
+#define BOT_DANGER_RADIUS 160.0f
+/* how much it strafes compared to backing off */
+#define BOT_STRAFE 0.6f
+/* the aim grid is BOT_AIM_CELLS x BOT_AIM_CELLS over the screen */
+#define BOT_AIM_CELLS 8
+
+typedef struct {
+    /* ticks until the next decision */
+    int cooldown;
+    int move_x, move_y;
+    Vector2 aim;
+} Bot;
+
+void UpdateBot(Game*);
+
+#endif /* _BOT_H_ */
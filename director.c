@@ -0,0 +1,88 @@
+#include "director.h"
+#include "game.h"
+
+_Static_assert(E_COUNT <= 8, "SpawnDirector.credit is too small");
+
+/* don't let a long stall turn into a wall of enemies */
+#define MAX_CREDIT 8.0f
+
+void InitSpawnDirector(Game *game) {
+    game->director = (SpawnDirector){ .toughness = 1.0f };
+}
+
+float SpawnRate(Game *game, int type) {
+    EntityAttrs *attrs = &game->config.entitydata[type];
+    float minutes = game->ui.gametime / 60.0f;
+
+    if (attrs->spawn_interval <= 0 || game->ui.gametime < attrs->spawn_curve.start_time) {
+        return 0;
+    }
+    return (1.0f / attrs->spawn_interval) * (1.0f + attrs->spawn_curve.ramp * powf(minutes, attrs->spawn_curve.exponent));
+}
+
+static int live_enemies(Game *game) {
+    int n = 0;
+    for (int i = 0; i < len(game->config.enemy_types); i++) {
+        n += game->entities[game->config.enemy_types[i]].length;
+    }
+    return n;
+}
+
+/* everything GameTick goes through one by one */
+static int tick_work(Game *game) {
+    int n = game->hostile.count;
+
+    for (int i = 0; i < E_COUNT; i++) {
+        n += game->entities[i].length;
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        n += game->particles[i].length;
+    }
+    return n;
+}
+
+void DirectorMeasureTick(Game *game, double secs) {
+    SpawnDirector *d = &game->director;
+
+    // the clock would make batch results depend on the machine and the thread count
+    if (game->headless) {
+        secs = tick_work(game) * game->config.director.secs_per_entity;
+    }
+    d->tick_time += (secs - d->tick_time) * game->config.director.smoothing;
+}
+
+void UpdateSpawnDirector(Game *game) {
+    SpawnDirector *d = &game->director;
+    DirectorConfig *c = &game->config.director;
+    float dt = 1.0f / game->config.target_fps;
+    EntityType type;
+    Entity batch[(int) MAX_CREDIT];
+    int count;
+
+    d->load = fmaxf(d->tick_time / c->tick_budget, (float) live_enemies(game) / c->max_live_enemies);
+
+    /* over budget -> tougher, under budget -> ease back towards 1.
+       enemies live for a while, so the count reacts slowly to this and
+       it has to move slowly too or it just swings back and forth */
+    d->toughness *= expf(c->response * (d->load - 1.0f) * dt);
+    d->toughness = fminf(fmaxf(d->toughness, 1.0f), c->max_toughness);
+    d->merge_radius = fminf((d->toughness - 1.0f) * c->merge_per_toughness, c->max_merge_radius);
+
+    for (int i = 0; i < len(game->config.enemy_types); i++) {
+        type = game->config.enemy_types[i];
+        d->credit[type] = fminf(d->credit[type] + SpawnRate(game, type) * dt, MAX_CREDIT * d->toughness);
+
+        /* everything owed this tick goes out as one batch, storage is
+           already reserved (ReserveStorage) so this never reallocates.
+           credit is capped at MAX_CREDIT spawns' worth, so it fits */
+        count = (int) (d->credit[type] / d->toughness);
+        d->credit[type] -= count * d->toughness;
+
+        for (int n = 0; n < count; n++) {
+            batch[n] = RandSpawnEnemy(game, type);
+            batch[n].max_hp = batch[n].hp = batch[n].max_hp * d->toughness;
+            batch[n].size *= fminf(sqrtf(d->toughness), DIRECTOR_MAX_GROWTH);
+        }
+        AddEntities(game, batch, count);
+    }
+}
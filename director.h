@@ -0,0 +1,75 @@
+#ifndef _DIRECTOR_H_
+#define _DIRECTOR_H_
+
+/*
+    spawn director, replaces the fixed enemy spawn timers.
+
+    each enemy type spawns at a rate that ramps up over gametime:
+        rate = (1 / spawn_interval) * (1 + ramp * minutes^exponent)
+    once the type's start_time has passed.
+
+    it also watches how long GameTick takes and how many enemies are
+    alive. headless runs cost the tick by what's in it instead of by the
+    clock (secs_per_entity each), so a seed plays out the same on any
+    machine and with any number of batch threads. when either is over
+    budget, the extra load goes into fewer,
+    tougher enemies instead of more of them:
+    - with toughness t, every t spawns' worth of rate becomes one enemy
+      with t times the hp
+    - enemies closer than merge_radius to one of their own type merge
+      into it (see AbsorbEnemy), so the ones already out there thin out
+      too instead of waiting to be killed
+*/
+
+typedef struct Game Game;
+
+/* how much bigger than normal an enemy can get, as a multiple of its size */
+#define DIRECTOR_MAX_GROWTH 3.0f
+
+/* per enemy type, in EntityAttrs */
+typedef struct {
+    float ramp;
+    float exponent;
+    /* seconds of gametime before this type shows up */
+    float start_time;
+} SpawnCurve;
+
+typedef struct {
+    /* seconds of GameTick we're willing to spend */
+    float tick_budget;
+    /* headless: what each live entity, particle and shot counts as */
+    float secs_per_entity;
+    /* enemies alive before we start making them tougher instead */
+    int max_live_enemies;
+    /* how much of each new tick time goes into the average, 0-1 */
+    float smoothing;
+    /* how fast toughness follows the load, per second */
+    float response;
+    /* toughness never goes past this */
+    float max_toughness;
+    /* merge radius in pixels per point of toughness over 1 */
+    float merge_per_toughness;
+    float max_merge_radius;
+} DirectorConfig;
+
+typedef struct {
+    /* spawns owed, per entity type */
+    float credit[8];
+    /* moving average of GameTick's duration */
+    float tick_time;
+    /* max of tick_time / budget and live / max_live */
+    float load;
+    /* hp multiplier for new spawns, >= 1 */
+    float toughness;
+    /* 0 when under budget */
+    float merge_radius;
+} SpawnDirector;
+
+void InitSpawnDirector(Game*);
+void UpdateSpawnDirector(Game*);
+/* feed it how long the last GameTick took, ignored when headless */
+void DirectorMeasureTick(Game*, double secs);
+
+float SpawnRate(Game*, int type);
+
+#endif /* _DIRECTOR_H_ */
@@ -0,0 +1,229 @@
+#include "flight.h"
+
+#include <fcntl.h>      /* open */
+#include <signal.h>     /* sigaction, raise */
+
+/* the one the crash handler dumps */
+static FlightRecorder *crash_recorder = NULL;
+
+static uint16_t saturate_u16(int n) {
+    return n > UINT16_MAX ? UINT16_MAX : n;
+}
+
+static int16_t clamp_i16(float v) {
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t) v;
+}
+
+static void write_entries(const FlightEntry *entries, int head, int count, uint32_t tick, const char *reason);
+
+static void *spike_thread(void *arg) {
+    FlightRecorder *fr = arg;
+
+    pthread_mutex_lock(&fr->lock);
+    while (true) {
+        while (!fr->spike_pending && !fr->stop) {
+            pthread_cond_wait(&fr->cond, &fr->lock);
+        }
+        if (!fr->spike_pending) {
+            break;
+        }
+        pthread_mutex_unlock(&fr->lock);
+
+        write_entries(fr->spike, fr->spike_head, fr->spike_count, fr->spike_tick, "spike");
+
+        pthread_mutex_lock(&fr->lock);
+        fr->spike_pending = false;
+    }
+    pthread_mutex_unlock(&fr->lock);
+    return NULL;
+}
+
+FlightRecorder *NewFlightRecorder(void) {
+    FlightRecorder *fr = MemAlloc(sizeof(FlightRecorder));
+
+    pthread_mutex_init(&fr->lock, NULL);
+    pthread_cond_init(&fr->cond, NULL);
+    pthread_create(&fr->thread, NULL, spike_thread, fr);
+    return fr;
+}
+
+void FreeFlightRecorder(FlightRecorder *fr) {
+    if (crash_recorder == fr) {
+        crash_recorder = NULL;
+    }
+
+    // a spike dump that's already been handed over still gets written
+    pthread_mutex_lock(&fr->lock);
+    fr->stop = true;
+    pthread_cond_signal(&fr->cond);
+    pthread_mutex_unlock(&fr->lock);
+    pthread_join(fr->thread, NULL);
+
+    pthread_mutex_destroy(&fr->lock);
+    pthread_cond_destroy(&fr->cond);
+    MemFree(fr);
+}
+
+void FlightRecordTick(FlightRecorder *fr, Game *game) {
+    FlightEntry *e = &fr->entries[fr->head];
+    int particles = 0;
+
+    for (int i = 0; i < P_COUNT; i++) {
+        particles += game->particles[i].length;
+    }
+
+    e->tick = ++fr->tick;
+    e->gametime_ms = game->ui.gametime * 1000;
+    e->frame_us = 0;
+    e->minimap_us = 0;
+    e->player_x = game->player.x;
+    e->player_y = game->player.y;
+    e->player_hp = game->player.hp;
+    e->move_x = game->input.move_x;
+    e->move_y = game->input.move_y;
+    e->aim_dx = clamp_i16(game->input.aim.x - game->player.x);
+    e->aim_dy = clamp_i16(game->input.aim.y - game->player.y);
+    for (int i = 0; i < E_COUNT; i++) {
+        e->counts[i] = saturate_u16(game->entities[i].length);
+    }
+    e->particles = saturate_u16(particles);
+
+    fr->head = (fr->head + 1) % FLIGHT_CAPACITY;
+    if (fr->count < FLIGHT_CAPACITY) {
+        fr->count++;
+    }
+}
+
+/* hands a copy of the ring to the writer. if it's still busy with the
+   last one that's skipped, the cooldown means it hardly ever is */
+static void spike_dump(FlightRecorder *fr) {
+    pthread_mutex_lock(&fr->lock);
+    if (!fr->spike_pending) {
+        memcpy(fr->spike, fr->entries, sizeof(fr->entries));
+        fr->spike_head = fr->head;
+        fr->spike_count = fr->count;
+        fr->spike_tick = fr->tick;
+        fr->spike_pending = true;
+        pthread_cond_signal(&fr->cond);
+    }
+    pthread_mutex_unlock(&fr->lock);
+}
+
+void FlightRecordFrameTime(FlightRecorder *fr, double secs) {
+    double now;
+
+    if (fr->count == 0) {
+        return;
+    }
+    fr->entries[(fr->head + FLIGHT_CAPACITY - 1) % FLIGHT_CAPACITY].frame_us = secs * 1e6;
+
+    if (secs > FLIGHT_SPIKE_SECS) {
+        now = GetTime();
+        if (fr->last_spike_dump == 0 || now - fr->last_spike_dump > FLIGHT_SPIKE_COOLDOWN_SECS) {
+            fr->last_spike_dump = now;
+            spike_dump(fr);
+        }
+    }
+}
+
+void FlightRecordMinimapTime(FlightRecorder *fr, double secs) {
+    if (fr->count > 0) {
+        fr->entries[(fr->head + FLIGHT_CAPACITY - 1) % FLIGHT_CAPACITY].minimap_us = secs * 1e6;
+    }
+}
+
+/* signal safe formatting, no printf */
+
+static char *append_str(char *p, const char *s) {
+    while (*s) *p++ = *s++;
+    return p;
+}
+
+static char *append_int(char *p, long n) {
+    char digits[24];
+    int len = 0;
+    unsigned long u = n < 0 ? -(unsigned long) n : (unsigned long) n;
+
+    if (n < 0) *p++ = '-';
+    do {
+        digits[len++] = '0' + u % 10;
+        u /= 10;
+    } while (u > 0);
+    while (len > 0) *p++ = digits[--len];
+    return p;
+}
+
+void DumpFlightRecorder(FlightRecorder *fr, const char *reason) {
+    write_entries(fr->entries, fr->head, fr->count, fr->tick, reason);
+}
+
+static void write_entries(const FlightEntry *entries, int head, int count, uint32_t tick, const char *reason) {
+    char line[256], *p;
+    int fd, start;
+    const FlightEntry *e;
+
+    p = append_str(line, "flight_");
+    p = append_str(p, reason);
+    p = append_str(p, "_");
+    p = append_int(p, tick);
+    p = append_str(p, ".txt");
+    *p = '\0';
+
+    if ((fd = open(line, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+        return;
+    }
+
+    p = append_str(line, "tick\tgametime_ms\tframe_us\tminimap_us\tx\ty\thp\tmove_x\tmove_y\taim_dx\taim_dy");
+    for (int i = 0; i < E_COUNT; i++) {
+        p = append_str(p, "\tcount");
+        p = append_int(p, i);
+    }
+    p = append_str(p, "\tparticles\n");
+    write(fd, line, p - line);
+
+    start = (head + FLIGHT_CAPACITY - count) % FLIGHT_CAPACITY;
+    for (int i = 0; i < count; i++) {
+        e = &entries[(start + i) % FLIGHT_CAPACITY];
+        p = line;
+        p = append_int(p, e->tick);         *p++ = '\t';
+        p = append_int(p, e->gametime_ms);  *p++ = '\t';
+        p = append_int(p, e->frame_us);     *p++ = '\t';
+        p = append_int(p, e->minimap_us);   *p++ = '\t';
+        p = append_int(p, e->player_x);     *p++ = '\t';
+        p = append_int(p, e->player_y);     *p++ = '\t';
+        p = append_int(p, e->player_hp);    *p++ = '\t';
+        p = append_int(p, e->move_x);       *p++ = '\t';
+        p = append_int(p, e->move_y);       *p++ = '\t';
+        p = append_int(p, e->aim_dx);       *p++ = '\t';
+        p = append_int(p, e->aim_dy);
+        for (int j = 0; j < E_COUNT; j++) {
+            *p++ = '\t';
+            p = append_int(p, e->counts[j]);
+        }
+        *p++ = '\t';
+        p = append_int(p, e->particles);
+        *p++ = '\n';
+        write(fd, line, p - line);
+    }
+
+    close(fd);
+}
+
+static void crash_handler(int sig) {
+    if (crash_recorder != NULL) {
+        DumpFlightRecorder(crash_recorder, sig == SIGSEGV ? "segv" : "abort");
+    }
+    /* SA_RESETHAND put the default back, so this crashes for real */
+    raise(sig);
+}
+
+void InstallFlightCrashHandler(FlightRecorder *fr) {
+    struct sigaction sa = {0};
+
+    crash_recorder = fr;
+    sa.sa_handler = crash_handler;
+    sa.sa_flags = SA_RESETHAND;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGSEGV, &sa, NULL);
+    sigaction(SIGABRT, &sa, NULL);
+}
@@ -0,0 +1,84 @@
+#ifndef _FLIGHT_H_
+#define _FLIGHT_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+/*
+    flight recorder: the last FLIGHT_SECONDS of per-tick summaries and
+    input in a fixed ring, allocated once. recording a tick is one small
+    struct write.
+
+    the ring is written out as text (one line per tick, oldest first):
+    - when a frame takes longer than FLIGHT_SPIKE_SECS
+    - on SIGSEGV / SIGABRT
+    - on F8
+    the dump only uses open/write and its own number formatting so it's
+    safe to call from a signal handler. a spike isn't written there and
+    then, that would be another hitch straight after the one it's about:
+    the ring is copied and a thread of its own writes the copy.
+*/
+
+#define FLIGHT_SECONDS 30
+#define FLIGHT_CAPACITY (FLIGHT_SECONDS * 60)
+/* two frames at 60 fps */
+#define FLIGHT_SPIKE_SECS (2.0 / 60.0)
+/* don't dump on every frame of a slow patch */
+#define FLIGHT_SPIKE_COOLDOWN_SECS 10.0
+
+typedef struct {
+    uint32_t tick;
+    uint32_t gametime_ms;
+    /* wall time of the frame this tick ran in, 0 if headless */
+    uint32_t frame_us;
+    /* the part of that spent redrawing the minimap, 0 if it wasn't */
+    uint32_t minimap_us;
+    /* whole pixels */
+    int32_t player_x, player_y;
+    int16_t player_hp;
+    /* input */
+    int8_t move_x, move_y;
+    int16_t aim_dx, aim_dy;
+    /* saturate at 65535 */
+    uint16_t counts[E_COUNT];
+    uint16_t particles;
+} FlightEntry;
+
+struct FlightRecorder {
+    FlightEntry entries[FLIGHT_CAPACITY];
+    /* where the next entry goes */
+    int head;
+    int count;
+    uint32_t tick;
+    double last_spike_dump;
+
+    /* the spike writer. the main thread only fills spike while
+       spike_pending is false, the writer only reads it while it's true */
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    FlightEntry spike[FLIGHT_CAPACITY];
+    int spike_head, spike_count;
+    uint32_t spike_tick;
+    bool spike_pending, stop;
+};
+
+FlightRecorder *NewFlightRecorder(void);
+void FreeFlightRecorder(FlightRecorder*);
+
+void FlightRecordTick(FlightRecorder*, Game*);
+/* call once per frame after the tick, dumps if it was a spike (on the
+   writer thread, this only copies the ring) */
+void FlightRecordFrameTime(FlightRecorder*, double secs);
+void FlightRecordMinimapTime(FlightRecorder*, double secs);
+
+/* reason goes in the file name: flight_<reason>_<tick>.txt */
+void DumpFlightRecorder(FlightRecorder*, const char *reason);
+
+/* dumps the recorder on SIGSEGV/SIGABRT, then crashes as normal */
+void InstallFlightCrashHandler(FlightRecorder*);
+
+#endif /* _FLIGHT_H_ */
@@ -1,13 +1,12 @@
 #include "game.h"
-
-extern ScreenSizeFunc GraphicsGetScreenSize;
-extern ScreenOffsetFunc GraphicsGetScreenOffset;
+#include "flight.h"
+#include "record.h"
+#include "snapshot.h"
 
 /* entity attribute access */
-#define getattr(etype, attr) (game.config.entitydata[etype].attr)
+#define getattr(etype, attr) (game->config.entitydata[etype].attr)
 // 50/50 chance
-#define cointoss(a, b) ((rand() % 2) ? a : b)
-#define len(arr) ((int)(sizeof(arr) / sizeof(*arr)))
+#define cointoss(a, b) ((rand_r(&game->rng) % 2) ? a : b)
 
 #define debug fprintf(stderr, "%d [%lf]\n", __LINE__, GetTime())
 
@@ -21,9 +20,6 @@ extern ScreenOffsetFunc GraphicsGetScreenOffset;
     - kill count or EXP bar
     - player direction indicator (points @ mouse cursor)
 
-    - make damaging particles only contact once (HARD)
-    - or just divide damage by lifetime lol
-
     - add heart containers
 
     - add 2 more types of enemies (4 in total) and spawn all of them randomly
@@ -38,15 +34,12 @@ extern ScreenOffsetFunc GraphicsGetScreenOffset;
     - fix the inputs so A+D won't freeze, but whichever was pressed first takes precedence
     - upgrade tree?
     - keymaps?
-    - enemy status effects (on fire/frozen)?
 
     - quadtrees? https://gamedevelopment.tutsplus.com/tutorials/quick-tip-use-quadtrees-to-detect-likely-collisions-in-2d-space--gamedev-374
     - this is a must if comparisons_per_frame goes to shit
 */
 
-bool show_hitboxes = false;
-
-Game game = {
+const Game game_defaults = {
     .config = {
         .window_initialized = false,
         .window_init_dim = (Vector2) { 800, 450 },
@@ -57,44 +50,237 @@ Game game = {
         .enemy_types = {
             E_ENEMY_BASIC,
             E_ENEMY_LARGE,
+            E_ENEMY_RANGED,
         },
         .projectile_types = {
             E_PLAYER_BULLET,
             E_PLAYER_SHELL,
+            E_PLAYER_SPIKE,
+            E_PLAYER_ARC,
+        },
+        .director = {
+            /* a quarter of a 60 fps frame, the rest is for drawing */
+            .tick_budget = 0.004,
+            /* about what one costs now, so headless runs see roughly what a real one would */
+            .secs_per_entity = 0.000001,
+            .max_live_enemies = 3000,
+            .smoothing = 0.05,
+            .response = 0.1,
+            .max_toughness = 50,
+            .merge_per_toughness = 4,
+            .max_merge_radius = 40,
+        },
+        .weapons = {
+            {
+                .name = "pistol",
+                .projectile = E_PLAYER_BULLET,
+                .pattern = PATTERN_SPREAD,
+                .aim = AIM_NEAREST,
+                .interval = 1.0,
+                .count = 1,
+            },
+            {
+                .name = "mortar",
+                .projectile = E_PLAYER_SHELL,
+                .pattern = PATTERN_SPREAD,
+                .aim = AIM_CURSOR,
+                .interval = 4.0,
+                .count = 1,
+            },
+            {
+                .name = "lance",
+                .projectile = E_PLAYER_SPIKE,
+                .pattern = PATTERN_SPREAD,
+                .aim = AIM_CURSOR,
+                .interval = 2.0,
+                .count = 3,
+                .spread = 20,
+            },
+            {
+                .name = "arc",
+                .projectile = E_PLAYER_ARC,
+                .pattern = PATTERN_SPREAD,
+                .aim = AIM_NEAREST,
+                .interval = 3.0,
+                .count = 1,
+            },
+            {
+                .name = "burst",
+                .projectile = E_PLAYER_BULLET,
+                .pattern = PATTERN_BURST,
+                .aim = AIM_NEAREST,
+                .interval = 2.5,
+                .count = 4,
+                .burst_gap = 0.08,
+            },
+            {
+                .name = "spiral",
+                .projectile = E_PLAYER_BULLET,
+                .pattern = PATTERN_SPIRAL,
+                .interval = 0.25,
+                .count = 4,
+                .spin = 15,
+            },
+        },
+        .hostile = {
+            .speed = 3.0,
+            .size = 3,
+            .damage = 5,
+            .max_shots = 4000,
+        },
+        .gems = {
+            .magnet_radius = 80,
+            .pickup_radius = 8,
+            .pull_speed = 6,
+            .merge_at = 5000,
+            .max_gems = 30000,
+            .cell_size = 48,
+        },
+        .numbers = {
+            .window = 0.25,
+            .lifetime = 0.8,
+            .rise = 30,
+            .font_size = 10,
+        },
+        .minimap = {
+            .size = 96,
+            .range = 2,
+            .interval = 0.1,
+            .screen_size = 25,
+        },
+        .status = {
+            [STATUS_BURN] = {
+                .duration = 3,
+                .interval = 0.5,
+                .damage = 15,
+                .max_stacks = 1,
+                .colour = ORANGE,
+            },
+            [STATUS_FROZEN] = {
+                .duration = 2,
+                .slow = 0.3,
+                .max_stacks = 1,
+                .colour = SKYBLUE,
+            },
+            [STATUS_POISON] = {
+                .duration = 6,
+                .interval = 1,
+                .damage = 5,
+                .max_stacks = 5,
+                .colour = LIME,
+            },
+        },
+        .melee = {
+            .interval = 1.5,
+            .radius = 60,
+            .arc = 120,
+            .damage = 150,
+            .active_ticks = 6,
+        },
+        .backgrounds = {
+            "./assets/background/bg_hextiles_large.png",
+            "./assets/background/bg_hextiles.png",
+            "./assets/background/bg_metalfloor.png",
+            "./assets/background/bg_original.png",
+            "./assets/background/test_100x100.png",
+        },
+        .texture_budget = 8 * 1024 * 1024,
+        /* about a large enemy across */
+        .grid_cell_size = 32,
+        /* the caps above come to about 1520k, areas another 2k,
+           hostile shots 80k and gems 400k */
+        .storage_budget = 2048 * 1024,
+        .max_areas = 64,
+        .quality = {
+            /* most of a 60 fps frame, the rest is for the driver */
+            .frame_budget = 0.014,
+            .step_down_at = 0.9,
+            .step_up_at = 0.6,
+            .step_down_secs = 0.25,
+            .step_up_secs = 3,
+            .smoothing = 0.1,
+            .levels = {
+                [QUALITY_HIGH] = {
+                    .fadeouts_per_tick = -1,
+                    .max_fadeouts = -1,
+                    .circle_segments = 36,
+                    .render_scale = 1.0,
+                    .hitboxes = true,
+                },
+                [QUALITY_MEDIUM] = {
+                    .fadeouts_per_tick = 8,
+                    .max_fadeouts = 200,
+                    .circle_segments = 16,
+                    .render_scale = 1.0,
+                },
+                [QUALITY_LOW] = {
+                    .fadeouts_per_tick = 4,
+                    .max_fadeouts = 60,
+                    .circle_segments = 10,
+                    .render_scale = 0.75,
+                },
+                [QUALITY_LOWEST] = {
+                    .fadeouts_per_tick = 1,
+                    .max_fadeouts = 15,
+                    .circle_segments = 6,
+                    .render_scale = 0.5,
+                },
+            },
         },
         .entitydata = {
             [E_PLAYER] = {
-                .child_spawns = {
-                    [E_PLAYER_BULLET] = 1.0f,
-                    [E_PLAYER_SHELL] = 4.0f,
-                },
                 .max_hp = 100,
                 .invincibility_time = 1.0,
                 .contact_damage = 0,
             },
             [E_ENEMY_BASIC] = {
                 .spawn_interval = 0.5,
+                .spawn_curve = { .ramp = 0.5, .exponent = 1.5 },
                 .speed = 1.0,
                 .size = 6,
                 .max_hp = 100,
                 .contact_damage = 10,
+                .xp = 1,
+                .max_count = 4000,
+                .evict = EVICT_FARTHEST,
                 .draw = DrawBasicEnemy,
                 .update = UpdateBasicEnemy,
             },
             [E_ENEMY_LARGE] = {
                 .spawn_interval = 5,
+                .spawn_curve = { .ramp = 1.0, .exponent = 1.5, .start_time = 20 },
                 .speed = 0.3,
                 .size = 30,
                 .max_hp = 500,
                 .contact_damage = 40,
+                .xp = 5,
+                .max_count = 1000,
+                .evict = EVICT_FARTHEST,
                 .draw = DrawLargeEnemy,
                 .update = UpdateLargeEnemy,
             },
+            [E_ENEMY_RANGED] = {
+                .spawn_interval = 4,
+                .spawn_curve = { .ramp = 0.75, .exponent = 1.5, .start_time = 40 },
+                .speed = 0.8,
+                .size = 8,
+                .max_hp = 150,
+                .contact_damage = 10,
+                .shot_interval = 2.0,
+                .shot_range = 250,
+                .xp = 3,
+                .max_count = 500,
+                .evict = EVICT_FARTHEST,
+                .draw = DrawRangedEnemy,
+                .update = UpdateRangedEnemy,
+            },
             [E_PLAYER_BULLET] = {
                 .spawn_interval = 1.0,
                 .speed = 4.0,
                 .size = 4.0,
                 .contact_damage = 100,
+                .max_count = 6000,
+                .evict = EVICT_OLDEST,
                 .draw = DrawBullet,
                 .update = UpdateProjectile,
             },
@@ -105,27 +291,61 @@ Game game = {
                 .contact_damage = 200,
                 /* TODO: make this the default for explosions */
                 .explosion_radius = 30.0,
+                .max_count = 1000,
+                .evict = EVICT_OLDEST,
                 .draw = DrawShell,
                 .update = UpdateProjectile,
-            }
+            },
+            [E_PLAYER_SPIKE] = {
+                .spawn_interval = 2.0,
+                .speed = 10.0,
+                .size = 8.0,
+                .contact_damage = 60,
+                .pierce = 5,
+                .inflicts = STATUS_BIT(STATUS_POISON),
+                .max_count = 1500,
+                .evict = EVICT_OLDEST,
+                .draw = DrawSpike,
+                .update = UpdateProjectile,
+            },
+            [E_PLAYER_ARC] = {
+                .spawn_interval = 3.0,
+                .speed = 12.0,
+                .size = 5.0,
+                .contact_damage = 80,
+                .chain = 4,
+                .chain_radius = 120,
+                .inflicts = STATUS_BIT(STATUS_FROZEN),
+                .max_count = 1500,
+                .evict = EVICT_OLDEST,
+                .draw = DrawArc,
+                .update = UpdateProjectile,
+            },
         },
         .particledata = {
             [P_EXPLOSION] = {
                 .starting_size = 2.0,
                 .lifetime = 10,
                 .damage = 200,
+                .inflicts = STATUS_BIT(STATUS_BURN),
+                .max_count = 500,
                 .draw = DrawPExplosion,
+                .update = UpdatePExplosion,
             },
             [P_ENEMY_FADEOUT_BASIC] = {
                 .starting_size = 6,
                 .lifetime = 8,
                 .damage = 0,
+                .max_count = 1000,
+                .cosmetic = true,
                 .draw = DrawPEnemyFadeout,
             },
             [P_ENEMY_FADEOUT_LARGE] = {
                 .starting_size = 30,
                 .lifetime = 8,
                 .damage = 0,
+                .max_count = 1000,
+                .cosmetic = true,
                 .draw = DrawPEnemyFadeout,
             },
             
@@ -140,48 +360,53 @@ Game game = {
             38, 55, 24, 10, "Try again?", RestartBtnCallback,
         },
     },
-    .textures = {
-        /* TODO: macro to initialize this from just a path? */
-        .background = {
-            .filepath = "./assets/background/bg_hextiles_large.png",
-            .data = NULL,
-        },
-    },
+    .show_hitboxes = false,
+    .headless = false,
 };
 
 
 /* game methods */
 
-void InitGame(void) {
+/* sets up everything that doesn't need a window */
+void InitGameContext(Game *game, unsigned int seed) {
 
-    srand(time(NULL));
-    
-    SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_VSYNC_HINT /*| FLAG_WINDOW_RESIZABLE*/);
-    InitWindow(screensize().x, screensize().y, game.config.window_title);
-    SetTargetFPS(game.config.target_fps);
-    game.config.window_initialized = true;
-    
-    GraphicsGetScreenOffset = screen_offset;
-    GraphicsGetScreenSize = screensize;
+    /* memcpy since Button's const label makes Game unassignable */
+    memcpy(game, &game_defaults, sizeof(Game));
+    game->rng = seed;
 
     for (int i = 0; i < E_COUNT; i++) {
-        vec_init(&game.entities[i]);
+        vec_init(&game->entities[i]);
     }
     for (int i = 0; i < P_COUNT; i++) {
-        vec_init(&game.particles[i]);
+        vec_init(&game->particles[i]);
     }
-
-    InitTexture(&game.textures.background);
-
-    game.state = GS_TITLE;
-    InitGameTimers();
-    game.camera = (Camera2D){
+    vec_init(&game->areas);
+    vec_init(&game->evicting);
+    vec_init(&game->volleys);
+    ReserveStorage(game);
+    InitHostile(game);
+    InitGems(game);
+    InitStatus(game);
+    InitSpatialGrid(&game->enemy_grid, game->config.grid_cell_size,
+        getattr(E_ENEMY_BASIC, max_count) + getattr(E_ENEMY_LARGE, max_count) + getattr(E_ENEMY_RANGED, max_count));
+    StartupMark("vec init");
+
+    game->state = GS_TITLE;
+    game->next_id = 1;
+    InitGameTimers(game);
+    StartupMark("timer init");
+    InitSpawnDirector(game);
+    InitQuality(game);
+    InitMelee(game);
+    InitWeapons(game);
+    game->camera = (Camera2D){
         .target = (Vector2){ 0, 0 },
         .zoom = 1.0f
     };
-    game.player = (Entity){
-        .x = screensize().x / 2,
-        .y = screensize().y / 2,
+    game->player = (Entity){
+        .type = E_PLAYER,
+        .x = screensize(game).x / 2,
+        .y = screensize(game).y / 2,
         .speed = 3,
         .size = 6,
         .max_hp = getattr(E_PLAYER, max_hp),
@@ -190,226 +415,445 @@ void InitGame(void) {
     };
 }
 
-void RunGame(void) {
+/* straight into gameplay, never touches raylib's window/input/textures */
+void InitGameHeadless(Game *game, unsigned int seed) {
+    InitGameContext(game, seed);
+    game->headless = true;
+    game->state = GS_GAMEPLAY;
+}
+
+void DestroyGameContext(Game *game) {
+    for (int i = 0; i < E_COUNT; i++) {
+        vec_deinit(&game->entities[i]);
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        vec_deinit(&game->particles[i]);
+    }
+    vec_deinit(&game->areas);
+    vec_deinit(&game->evicting);
+    vec_deinit(&game->volleys);
+    for (int i = 0; i < game->config.max_areas; i++) {
+        vec_deinit(&game->area_hits[i]);
+    }
+    MemFree(game->area_hits);
+    game->area_hits = NULL;
+    FreeMelee(game);
+    FreeHostile(game);
+    FreeGems(game);
+    FreeStatus(game);
+    FreeSpatialGrid(&game->enemy_grid);
+    if (game->flight != NULL) {
+        FreeFlightRecorder(game->flight);
+        game->flight = NULL;
+    }
+    /* the loader first, it writes into the cache's entries */
+    StopAssetLoader(game->loader);
+    game->loader = NULL;
+    FreeTextureCache(game->textures.cache);
+    game->textures.cache = NULL;
+}
+
+void InitGame(Game *game) {
+    double start = ClockSeconds();
+
+    InitGameContext(game, time(NULL));
+    game->ui.start_time = start;
+    
+    StartupMark("game context");
+    
+    SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_VSYNC_HINT /*| FLAG_WINDOW_RESIZABLE*/);
+    InitWindow(screensize(game).x, screensize(game).y, game->config.window_title);
+    StartupMark("InitWindow");
+    SetTargetFPS(game->config.target_fps);
+    StartupMark("SetTargetFPS");
+    game->config.window_initialized = true;
+    game->ui.idle_dirty = true;
+
+    /* the title screen doesn't need any of this, so it shows right away */
+    game->loader = StartAssetLoader(OpenAssetPack(ASSET_PACK_DEFAULT_PATH));
+    game->textures.cache = NewTextureCache(game->loader, game->config.texture_budget);
+    game->textures.background = AcquireTexture(game->textures.cache, game->config.backgrounds[0]);
+    PrefetchTexture(game->textures.cache, game->textures.background);
+    StartupMark("asset loader");
+
+    game->flight = NewFlightRecorder();
+    InstallFlightCrashHandler(game->flight);
+    StartupMark("flight recorder");
+}
+
+void RunGame(Game *game) {
+    bool first_frame = true, assets_reported = false;
     
     while (!WindowShouldClose()) {
         /* FPS control */
         static const double frametime = 1.0 / 60.0;
-        double time = GetTime();
+        double time;
+
+        /* a few finished textures onto the GPU. one that can't be loaded
+           is only fatal if it's the background there is to draw */
+        if (!PumpAssetUploads(game->loader, ASSET_UPLOADS_PER_FRAME) && game->textures.background->texture.failed) {
+            exit(1);
+        }
+        SwapBackground(game);
+        TrimTextureCache(game->textures.cache);
+        if (!assets_reported && AssetsLoaded(game->loader)) {
+            printf("Assets ready after %.2f ms (%s)\n",
+                (game->loader->finished - game->ui.start_time) * 1000,
+                game->loader->pack != NULL ? ASSET_PACK_DEFAULT_PATH : "decoded from assets/");
+            assets_reported = true;
+            StartupMark("background texture");
+            /* the screen might have been waiting on them */
+            game->ui.idle_dirty = true;
+        }
+
+        /* menus: check the input ourselves and only draw when it matters */
+        if (IdleState(game->state)) {
+            PollInputEvents();
+            if (!IdleShouldRedraw(game)) {
+                WaitTime(IDLE_WAIT_MS);
+                continue;
+            }
+        }
+
+        time = GetTime();
         BeginDrawing();
-        switch(game.state) {
+        if (first_frame) {
+            StartupMark("first BeginDrawing");
+        }
+        switch(game->state) {
             case GS_TITLE: {
-                DrawTitle();
+                DrawTitle(game);
                 break;
             }
             case GS_GAMEPLAY: {
-                DrawGameplay();
-                if (game.player.hp <= 0) {
-                    SetState(GS_GAMEOVER);
-                }
+                DrawGameplay(game);
                 break;
             }
             case GS_PAUSED: {
-                DrawPaused();
+                DrawPaused(game);
                 break;
             }
             case GS_GAMEOVER: {
-                DrawGameover();
+                DrawGameover(game);
                 break;
             }
             default: break;
         }
 
+        /* before EndDrawing, which also waits for vsync */
+        if (game->state == GS_GAMEPLAY) {
+            UpdateQuality(game, GetTime() - time);
+        }
         EndDrawing();
 
+        if (first_frame) {
+            StartupMark("first EndDrawing");
+            printf("First frame after %.2f ms\n", (ClockSeconds() - game->ui.start_time) * 1000);
+            first_frame = false;
+        }
+        if (!first_frame && assets_reported) {
+            ReportStartupProfile();
+        }
+
+        if (game->flight != NULL && game->state == GS_GAMEPLAY) {
+            FlightRecordFrameTime(game->flight, GetTime() - time);
+        }
+
         /* FPS control */
         GameSleep(frametime - (GetTime() - time));
     }
 }
 
 /* for restarting */
-void ReinitGame(void) {
+void ReinitGame(Game *game) {
 
     for (int i = 0; i < E_COUNT; i++) {
-        vec_clear(&game.entities[i]);
+        vec_clear(&game->entities[i]);
     }
     for (int i = 0; i < P_COUNT; i++) {
-        vec_clear(&game.particles[i]);
+        vec_clear(&game->particles[i]);
     }
-
-    game.state = GS_TITLE;
-    InitGameTimers();
-    game.camera = (Camera2D){
+    vec_clear(&game->areas);
+    game->hostile.count = 0;
+    ClearGems(game);
+    ClearStatus(game);
+    game->xp = 0;
+    ClearDamageNumbers(game);
+
+    game->state = GS_TITLE;
+    game->ui.gametime = 0;
+    InitGameTimers(game);
+    InitSpawnDirector(game);
+    InitWeapons(game);
+    game->melee.ticks_left = 0;
+    game->camera = (Camera2D){
         .target = (Vector2){ 0, 0 },
         .zoom = 1.0f
     };
-    game.player = (Entity){
-        .x = screensize().x / 2,
-        .y = screensize().y / 2,
+    game->player = (Entity){
+        .type = E_PLAYER,
+        .x = screensize(game).x / 2,
+        .y = screensize(game).y / 2,
         .speed = 3,
         .size = 6,
         .max_hp = getattr(E_PLAYER, max_hp),
         .hp = getattr(E_PLAYER, max_hp),
         .invincible = false,
     };
-    game.ui.gametime = 0;
 }
 
-void DestroyGame(void) {
-    CloseWindow();
-    game.config.window_initialized = false;
-    for (int i = 0; i < E_COUNT; i++) {
-        vec_deinit(&game.entities[i]);
-    }
-    for (int i = 0; i < P_COUNT; i++) {
-        vec_deinit(&game.particles[i]);
+void DestroyGame(Game *game) {
+    UnloadQuality(game);
+    UnloadDamageNumbers(game);
+    UnloadMinimap(game);
+    if (game->ui.paused_frame_loaded) {
+        UnloadRenderTexture(game->ui.paused_frame);
+        game->ui.paused_frame_loaded = false;
     }
-    DeinitTexture(&game.textures.background);
+    CloseWindow();
+    game->config.window_initialized = false;
+    DestroyGameContext(game);
 }
 
 /* contains initialization logic for each state */
-void SetState(GameState new_state) {
-    GameState old_state = game.state;
+void SetState(Game *game, GameState new_state) {
+    GameState old_state = game->state;
     /* if starting */
     if (old_state == GS_TITLE && new_state == GS_GAMEPLAY) {
         /* don't wanna fire immediately when the game starts */
-        InitGameTimers();
+        InitGameTimers(game);
+        InitSpawnDirector(game);
     }
     /* if starting over */
     else if (old_state == GS_GAMEOVER && new_state == GS_GAMEPLAY) {
-        ReinitGame();
+        ReinitGame(game);
+    }
+    /* if pausing, DrawPaused captures the world on its first frame */
+    else if (new_state == GS_PAUSED) {
+        game->ui.paused_frame_valid = false;
     }
     /* if player is dead */
     else if (old_state == GS_GAMEPLAY && new_state == GS_GAMEOVER) {
-        game.player.x = screensize().x / 2;
-        game.player.y = screensize().y / 2;
-        UpdateCam();
+        game->player.x = screensize(game).x / 2;
+        game->player.y = screensize(game).y / 2;
+        UpdateCam(game);
     }
 
-    game.state = new_state;
+    game->state = new_state;
+    game->ui.idle_dirty = true;
 }
 
-void HandleInput(void) {
-    Entity *player = &game.player;
-    float slow_speed = player->speed / (2 * sqrt(2.0));
-    float fast_speed = player->speed;
+/* everything DrawWorld needs is on the GPU */
+bool GameplayAssetsReady(Game *game) {
+    return game->textures.background != NULL && game->textures.background->texture.loaded;
+}
+
+/* states where nothing moves unless the player does something */
+bool IdleState(GameState state) {
+    return state == GS_TITLE || state == GS_PAUSED || state == GS_GAMEOVER;
+}
+
+/* call after PollInputEvents. true if the screen could look different from
+   the last frame or there's input that drawing the frame would act on */
+bool IdleShouldRedraw(Game *game) {
+    bool hover = false, focused = IsWindowFocused(), changed;
+
+    if (game->state == GS_TITLE) {
+        hover = MouseInside(screen_view(game), game->ui.start_btn);
+    } else if (game->state == GS_GAMEOVER) {
+        hover = MouseInside(screen_view(game), game->ui.restart_btn);
+    }
+
+    changed = game->ui.idle_dirty
+        || hover != game->ui.idle_hover
+        || focused != game->ui.idle_focused
+        || IsWindowResized()
+        || GetKeyPressed() != 0
+        || IsMouseButtonPressed(MOUSE_BUTTON_LEFT)
+        || IsMouseButtonReleased(MOUSE_BUTTON_LEFT);
+
+    game->ui.idle_dirty = false;
+    game->ui.idle_hover = hover;
+    game->ui.idle_focused = focused;
+    return changed;
+}
+
+/* one step of the simulation - no drawing, no input devices */
+void GameTick(Game *game) {
+    double start = ClockSeconds();
+
+    game->quality.fadeouts_this_tick = 0;
+    if (game->autopilot) {
+        UpdateBot(game);
+    }
+    MovePlayer(game, game->input.move_x, game->input.move_y);
+
+    CheckTimers(game);
+    UpdateWeapons(game);
+    UpdateSpawnDirector(game);
+    UpdateEntities(game);
+    UpdateHostileShots(game);
+    UpdateAreaDamage(game);
+    UpdateMelee(game);
+    UpdateStatus(game);
+    // the grid's done with, everything that died this tick can go
+    RemoveDeadEnemies(game);
+    UpdateGems(game);
+    UpdateParticles(game);
+    UpdateGameTime(game);
+
+    if (game->recorder != NULL) {
+        RecordTick(game->recorder, game);
+    }
+    if (game->flight != NULL) {
+        FlightRecordTick(game->flight, game);
+    }
+    DirectorMeasureTick(game, ClockSeconds() - start);
+
+    if (game->player.hp <= 0) {
+        SetState(game, GS_GAMEOVER);
+    }
+}
+
+/* reads the keyboard and mouse into game->input, GameTick does the rest */
+void HandleInput(Game *game) {
 
     // for debugging
     if (IsKeyPressed(KEY_K)) {
-        //game.ui.gametime += 260000;
-        game.player.hp = 0;
+        //game->ui.gametime += 260000;
+        game->player.hp = 0;
         return;
     }
 
+    if (IsKeyPressed(KEY_F5) && (game->state == GS_GAMEPLAY || game->state == GS_PAUSED)) {
+        SaveSnapshot(game, SNAPSHOT_DEFAULT_PATH);
+    }
+    if (IsKeyPressed(KEY_F9)) {
+        LoadSnapshot(game, SNAPSHOT_DEFAULT_PATH);
+        game->ui.paused_frame_valid = false;
+        return;
+    }
+
+    if (IsKeyPressed(KEY_F8) && game->flight != NULL) {
+        DumpFlightRecorder(game->flight, "manual");
+    }
+
+    if (IsKeyPressed(KEY_F3)) {
+        game->show_metrics = !game->show_metrics;
+    }
+
+    if (IsKeyPressed(KEY_T)) {
+        CycleBackground(game);
+    }
+
+    if (IsKeyPressed(KEY_B)) {
+        game->autopilot = !game->autopilot;
+    }
+
     if (IsKeyPressed(KEY_P)) {
-        if (game.state == GS_GAMEPLAY) {
-            SetState(GS_PAUSED);
+        if (game->state == GS_GAMEPLAY) {
+            SetState(game, GS_PAUSED);
             return;
-        } else if (game.state == GS_PAUSED) {
-            SetState(GS_GAMEPLAY);
+        } else if (game->state == GS_PAUSED) {
+            SetState(game, GS_GAMEPLAY);
             return;
         }
     }
 
     /* keep this here i forget why it's needed */
-    if (game.state != GS_GAMEPLAY) {
+    if (game->state != GS_GAMEPLAY) {
         return;
     }
 
+    /* the bot fills in the input itself */
+    if (game->autopilot) {
+        return;
+    }
+
+    game->input.aim = (Vector2){ screen_offset(game).x + GetMouseX(), screen_offset(game).y + GetMouseY() };
+
     /* movement */
 
+    game->input.move_x = 0;
+    game->input.move_y = 0;
+
     // invalid input?
-    if (!((IsKeyDown(KEY_W) && IsKeyDown(KEY_S)) || (IsKeyDown(KEY_A) && IsKeyDown(KEY_D)))) {
-
-        if (IsKeyDown(KEY_W)) {
-            if (IsKeyDown(KEY_A)) {
-                player->x -= slow_speed;
-                player->y -= slow_speed;
-            } else if (IsKeyDown(KEY_D)) {
-                player->x += slow_speed;
-                player->y -= slow_speed;
-            } else {
-                player->y -= fast_speed;
-            }
-        }
-        if (IsKeyDown(KEY_A)) {
-            if (IsKeyDown(KEY_W)) {
-                player->x -= slow_speed;
-                player->y -= slow_speed;
-            } else if (IsKeyDown(KEY_S)) {
-                player->x -= slow_speed;
-                player->y += slow_speed;
-            } else {
-                player->x -= fast_speed;
-            }
-        }
-        if (IsKeyDown(KEY_S)) {
-            if (IsKeyDown(KEY_A)) {
-                player->x -= slow_speed;
-                player->y += slow_speed;
-            } else if (IsKeyDown(KEY_D)) {
-                player->x += slow_speed;
-                player->y += slow_speed;
-            } else {
-                player->y += fast_speed;
-            }
-        }
-        if (IsKeyDown(KEY_D)) {
-            if (IsKeyDown(KEY_W)) {
-                player->x += slow_speed;
-                player->y -= slow_speed;
-            } else if (IsKeyDown(KEY_S)) {
-                player->x += slow_speed;
-                player->y += slow_speed;
-            } else {
-                player->x += fast_speed;
-            }
-        }
+    if ((IsKeyDown(KEY_W) && IsKeyDown(KEY_S)) || (IsKeyDown(KEY_A) && IsKeyDown(KEY_D))) {
+        return;
     }
+
+    if (IsKeyDown(KEY_W)) game->input.move_y = -1;
+    if (IsKeyDown(KEY_S)) game->input.move_y = 1;
+    if (IsKeyDown(KEY_A)) game->input.move_x = -1;
+    if (IsKeyDown(KEY_D)) game->input.move_x = 1;
 }
 
-void CheckTimers(void) {
-    CheckTimer(&game.timers.player_invinc);
-    CheckTimer(&game.timers.player_fire_bullet);
-    CheckTimer(&game.timers.player_fire_shell);
-    CheckTimer(&game.timers.basic_enemy_spawn);
-    CheckTimer(&game.timers.large_enemy_spawn);
+/* moves the player one tick in a direction, each axis is -1, 0 or 1 */
+void MovePlayer(Game *game, int move_x, int move_y) {
+    Entity *player = &game->player;
+    float diagonal_speed = player->speed / sqrt(2.0);
+    float straight_speed = player->speed;
+
+    if (move_x != 0 && move_y != 0) {
+        player->x += move_x * diagonal_speed;
+        player->y += move_y * diagonal_speed;
+    } else {
+        player->x += move_x * straight_speed;
+        player->y += move_y * straight_speed;
+    }
 }
 
-void UpdateCam(void) {
-    game.camera.offset = (Vector2) { GetScreenWidth()/2, GetScreenHeight()/2 };
-    game.camera.target = (Vector2){ game.player.x, game.player.y };
+void CheckTimers(Game *game) {
+    CheckTimer(&game->timers.player_invinc, game->ui.gametime, game);
+    CheckTimer(&game->timers.player_melee, game->ui.gametime, game);
 }
 
-void UpdateGameTime(void) {
-    game.ui.gametime += 1.0 / game.config.target_fps;
+void UpdateCam(Game *game) {
+    game->camera.offset = (Vector2) { screensize(game).x/2, screensize(game).y/2 };
+    game->camera.target = (Vector2){ game->player.x, game->player.y };
 }
 
-void InitTexture(GameTexture* t) {
-    Image temp = LoadImage(t->filepath);
-    if (temp.data == NULL) {
-        fprintf(stderr, "File not found: %s\n", t->filepath);
-        exit(1);
-    }
-    t->data = LoadTextureFromImage(temp);
-    UnloadImage(temp);
-    t->loaded = true;
+void UpdateGameTime(Game *game) {
+    game->ui.gametime += 1.0 / game->config.target_fps;
 }
 
-void DeinitTexture(GameTexture* t) {
-    UnloadTexture(t->data);
-    t->data = (Texture2D){0};
-    t->loaded = false;
+/* T: the next background, loaded in the background */
+void CycleBackground(Game *game) {
+    int n = len(game->config.backgrounds);
+
+    game->textures.background_index = (game->textures.background_index + 1) % n;
+    ReleaseTexture(game->textures.cache, game->textures.next_background);
+    game->textures.next_background = AcquireTexture(game->textures.cache, game->config.backgrounds[game->textures.background_index]);
+    PrefetchTexture(game->textures.cache, game->textures.next_background);
 }
 
-void InitGameTimers(void) {
-    game.timers = (GameTimers){
-        .basic_enemy_spawn = NewTimer(getattr(E_ENEMY_BASIC, spawn_interval), BasicEnemySpawnTimerCallback),
-        .large_enemy_spawn = NewTimer(getattr(E_ENEMY_LARGE, spawn_interval), LargeEnemySpawnTimerCallback),
+/* keeps drawing the old background until the new one is ready, or for
+   good if the new one couldn't be loaded */
+void SwapBackground(Game *game) {
+    CachedTexture *next = game->textures.next_background;
+
+    if (next != NULL && next->texture.failed) {
+        fprintf(stderr, "Keeping the current background, could not load %s\n", next->path);
+        ReleaseTexture(game->textures.cache, next);
+        game->textures.next_background = NULL;
+    } else if (next != NULL && next->texture.loaded) {
+        ReleaseTexture(game->textures.cache, game->textures.background);
+        game->textures.background = next;
+        game->textures.next_background = NULL;
+        game->ui.idle_dirty = true;
+        game->ui.paused_frame_valid = false;
+    }
+}
+
+void InitGameTimers(Game *game) {
+    game->timers = (GameTimers){
         .player_invinc = NewTimer(getattr(E_PLAYER, invincibility_time), PlayerInvincTimerCallback),
-        .player_fire_bullet = NewTimer(getattr(E_PLAYER, child_spawns)[E_PLAYER_BULLET], PlayerBulletTimerCallback),
-        .player_fire_shell = NewTimer(getattr(E_PLAYER, child_spawns)[E_PLAYER_SHELL], PlayerShellTimerCallback),
+        .player_melee = NewTimer(game->config.melee.interval, PlayerMeleeTimerCallback),
     };
+    // no callbacks, UpdateWeapons asks them how many volleys are due
+    for (int i = 0; i < MAX_WEAPONS; i++) {
+        game->timers.weapons[i] = NewTimer(game->config.weapons[i].interval, NULL);
+    }
 }
 
 /* unused */
@@ -419,57 +863,67 @@ void GameSleep(float secs) {
 
 /* gamestate draw functions */
 
-void DrawTitle(void) {
+void DrawTitle(Game *game) {
     ClearBackground((Color){170, 170, 170, 255});
-    DrawTextUI(game.config.window_title, 50, 45, 40, BLACK);
-    DrawButton(game.ui.start_btn);
-}
+    DrawTextUI(screen_view(game), game->config.window_title, 50, 45, 40, BLACK);
+    DrawButton(screen_view(game), game->ui.start_btn, game);
+}
+
+void DrawGameplay(Game *game) {
+    /* the clock doesn't start until there's something to see */
+    if (!GameplayAssetsReady(game)) {
+        UpdateCam(game);
+        BeginMode2D(game->camera);
+        ClearBackground((Color){170, 170, 170, 255});
+        DrawTextUI(screen_view(game), "Loading...", 50, 50, 40, BLACK);
+        EndMode2D();
+        return;
+    }
 
-void DrawGameplay(void) {
-    BeginMode2D(game.camera);
+    HandleInput(game);
+    if (game->state != GS_GAMEPLAY) {
+        return;
+    }
 
-    CheckTimers();
+    GameTick(game);
+    UpdateCam(game);
 
-    /* don't mess with this order */
-    TileBackground();
-    DrawGameUI();
-    DrawPlayer(true);
-    HandleInput();
-    UpdateCam();
-    DrawEntities(true);
-    DrawParticles(true);
-    
-    EndMode2D();
-    UpdateGameTime();
+    BeginWorldMode(game);
+    DrawWorld(game, true);
+    EndWorldMode(game);
 }
 
-void DrawPaused(void) {
+void DrawPaused(Game *game) {
+    Texture2D frame;
 
-    BeginMode2D(game.camera);
+    HandleInput(game);
+    UpdateCam(game);
 
-    TileBackground();
-    DrawGameUI();
-    DrawPlayer(false);
-    HandleInput();
-    UpdateCam();
-    DrawEntities(false);
-    DrawParticles(false);
+    /* nothing moves while paused, so the world is only drawn once */
+    if (!game->ui.paused_frame_valid) {
+        CapturePausedFrame(game);
+    }
+    frame = game->ui.paused_frame.texture;
+    /* render textures are upside down */
+    DrawTextureRec(frame, (Rectangle){ 0, 0, frame.width, -frame.height }, (Vector2){ 0, 0 }, WHITE);
+
+    BeginMode2D(game->camera);
 
-    DrawRectangleV(GraphicsGetScreenOffset(), GraphicsGetScreenSize(), (Color){180, 180, 180, 180});
-    DrawTextUI("PAUSED", 50, 50, 40, BLACK);
+    DrawRectangleRec(screen_view(game), (Color){180, 180, 180, 180});
+    DrawTextUI(screen_view(game), "PAUSED", 50, 50, 40, BLACK);
 
     EndMode2D();
     
 }
 
-void DrawGameover(void) {
+void DrawGameover(Game *game) {
 
-    BeginMode2D(game.camera);
+    BeginMode2D(game->camera);
 
     ClearBackground((Color){170, 170, 170, 255});
-    DrawButton(game.ui.restart_btn);
-    DrawTextUI("You Died", 50, 45, 40, BLACK);
-    DisplayGameTime();
+    DrawButton(screen_view(game), game->ui.restart_btn, game);
+    DrawTextUI(screen_view(game), "You Died", 50, 45, 40, BLACK);
+    DisplayGameTime(game);
 
     EndMode2D();
 
@@ -477,14 +931,58 @@ void DrawGameover(void) {
 
 /* draw functions */
 
+/* draws the world into ui.paused_frame for DrawPaused to show */
+void CapturePausedFrame(Game *game) {
+    RenderTexture2D *rt = &game->ui.paused_frame;
+    int w = screensize(game).x, h = screensize(game).y;
+
+    if (!game->ui.paused_frame_loaded || rt->texture.width != w || rt->texture.height != h) {
+        if (game->ui.paused_frame_loaded) {
+            UnloadRenderTexture(*rt);
+        }
+        *rt = LoadRenderTexture(w, h);
+        game->ui.paused_frame_loaded = true;
+    }
+
+    BeginTextureMode(*rt);
+    ClearBackground(RAYWHITE);
+    BeginMode2D(game->camera);
+    DrawWorld(game, false);
+    EndMode2D();
+    EndTextureMode();
+
+    /* try again once the background is in */
+    game->ui.paused_frame_valid = GameplayAssetsReady(game);
+}
+
+/* the whole scene, call inside BeginMode2D */
+void DrawWorld(Game *game, bool sprite_flickering) {
+    /* don't mess with this order */
+    TileBackground(game);
+    DrawGameUI(game);
+    DrawGems(game);
+    DrawPlayer(game, sprite_flickering);
+    DrawMelee(game);
+    DrawEntities(game);
+    DrawStatus(game);
+    DrawHostileShots(game);
+    DrawParticles(game);
+    DrawDamageNumbers(game);
+    DrawMinimap(game);
+}
+
 /* please don't mess with this please :) */
-void TileBackground(void) {
-    for (int i = ((game.player.x - GetScreenWidth()/2) / game.textures.background.data.width) - 1; i < ((game.player.x + GetScreenWidth()/2) / game.textures.background.data.width) + 1; i++) {
-        for (int j = ((game.player.y - GetScreenHeight()/2) / game.textures.background.data.height) - 1; j < ((game.player.y + GetScreenHeight()/2) / game.textures.background.data.height) + 1; j++) {
+void TileBackground(Game *game) {
+    Texture2D *bg = UseTexture(game->textures.cache, game->textures.background);
+    if (bg == NULL) {
+        return;
+    }
+    for (int i = ((game->player.x - screensize(game).x/2) / bg->width) - 1; i < ((game->player.x + screensize(game).x/2) / bg->width) + 1; i++) {
+        for (int j = ((game->player.y - screensize(game).y/2) / bg->height) - 1; j < ((game->player.y + screensize(game).y/2) / bg->height) + 1; j++) {
             DrawTexture(
-                game.textures.background.data,
-                i * game.textures.background.data.width,
-                j * game.textures.background.data.height,
+                *bg,
+                i * bg->width,
+                j * bg->height,
                 (Color){255, 255, 255, 255}
             );
         }
@@ -495,102 +993,163 @@ void DrawEntityHitbox(Entity *e) {
     DrawRectangleLinesEx(EntityHitbox(*e), 1.0, BLACK);
 }
 
-void DrawPlayer(bool sprite_flickering) {
+void DrawPlayer(Game *game, bool sprite_flickering) {
     // sprite flickering
-    if (((game.player.invincible && (int)(GetTime() * 10000) % 200 >= 100) || !game.player.invincible) || !sprite_flickering) {
-        DrawCircle(game.player.x, game.player.y, game.player.size, BLACK);
-        DrawCircle(game.player.x, game.player.y, game.player.size * 3/4, (Color){60, 60, 60, 255});
+    if (((game->player.invincible && (int)(GetTime() * 10000) % 200 >= 100) || !game->player.invincible) || !sprite_flickering) {
+        DrawCircleQ(game, game->player.x, game->player.y, game->player.size, BLACK);
+        DrawCircleQ(game, game->player.x, game->player.y, game->player.size * 3/4, (Color){60, 60, 60, 255});
     }
 }
 
-void DamagePlayer(int amount) {
-    if (!game.player.invincible) {
-        game.player.hp -= amount;
-        if (game.player.hp >= 0) {
-            game.player.invincible = true;
+void DamagePlayer(Game *game, int amount) {
+    if (!game->player.invincible) {
+        game->player.hp -= amount;
+        if (game->player.hp >= 0) {
+            game->player.invincible = true;
         }
     }
 }
 
-void HealPlayer(int amount) {
-    game.player.hp += amount;
-    if (game.player.hp >= game.player.max_hp) {
-        game.player.hp = game.player.max_hp;
+void HealPlayer(Game *game, int amount) {
+    game->player.hp += amount;
+    if (game->player.hp >= game->player.max_hp) {
+        game->player.hp = game->player.max_hp;
     }
 }
 
 /* generics */
 
-void DrawEntity(Entity *e) {
-    game.config.entitydata[e->type].draw(e);
+void DrawEntity(Game *game, Entity *e) {
+    game->config.entitydata[e->type].draw(game, e);
+}
+
+void UpdateEntity(Game *game, Entity *e) {
+    game->config.entitydata[e->type].update(game, e);
 }
 
-void UpdateEntity(Entity *e) {
-    game.config.entitydata[e->type].update(e);
+void DrawBasicEnemy(Game *game, Entity *enemy) {
+    DrawCircleQ(game, enemy->x, enemy->y, enemy->size, MAROON);
+    DrawCircleQ(game, enemy->x, enemy->y, enemy->size * 2/3, RED);
 }
 
-void DrawBasicEnemy(Entity *enemy) {
-    DrawCircle(enemy->x, enemy->y, enemy->size, MAROON);
-    DrawCircle(enemy->x, enemy->y, enemy->size * 2/3, RED);
+void UpdateBasicEnemy(Game *game, Entity *enemy) {
+    MoveEntityToPlayer(game, enemy);
 }
 
-void UpdateBasicEnemy(Entity *enemy) {
-    MoveEntityToPlayer(enemy);
+void DrawLargeEnemy(Game *game, Entity *enemy) {
+    DrawCircleQ(game, enemy->x, enemy->y, enemy->size, BLACK);
+    DrawCircleQ(game, enemy->x, enemy->y, enemy->size * 2/3, MAROON);
 }
 
-void DrawLargeEnemy(Entity *enemy) {
-    DrawCircle(enemy->x, enemy->y, enemy->size, BLACK);
-    DrawCircle(enemy->x, enemy->y, enemy->size * 2/3, MAROON);
+void UpdateLargeEnemy(Game *game, Entity *enemy) {
+    MoveEntityToPlayer(game, enemy);
 }
 
-void UpdateLargeEnemy(Entity *enemy) {
-    MoveEntityToPlayer(enemy);
+void DrawRangedEnemy(Game *game, Entity *enemy) {
+    DrawCircleQ(game, enemy->x, enemy->y, enemy->size, DARKPURPLE);
+    DrawCircleQ(game, enemy->x, enemy->y, enemy->size * 2/3, VIOLET);
 }
 
-void DrawProjectile(Entity *proj) {
+/* walks in until the player's in range, then stands there shooting */
+void UpdateRangedEnemy(Game *game, Entity *enemy) {
+    float range = getattr(enemy->type, shot_range);
+    float dist = entity_distance(*enemy, game->player);
+    unsigned int every = getattr(enemy->type, shot_interval) * game->config.target_fps;
+    unsigned int tick = lroundf(game->ui.gametime * game->config.target_fps);
+
+    if (dist > range * 3/4) {
+        MoveEntityToPlayer(game, enemy);
+    }
+    // the id staggers them, so a crowd of them doesn't fire all at once
+    if (every > 0 && dist <= range && (tick + enemy->id) % every == 0) {
+        FireHostileShot(game, enemy->x, enemy->y, entity_angle(*enemy, game->player));
+    }
+}
+
+void DrawProjectile(Game *game, Entity *proj) {
     switch (proj->type) {
-        case E_PLAYER_BULLET:   return DrawBullet(proj);
-        case E_PLAYER_SHELL:    return DrawShell(proj);
+        case E_PLAYER_BULLET:   DrawBullet(game, proj); return;
+        case E_PLAYER_SHELL:    DrawShell(game, proj); return;
+        case E_PLAYER_SPIKE:    DrawSpike(game, proj); return;
+        case E_PLAYER_ARC:      DrawArc(game, proj); return;
         default:                return;
     }
 }
 
-/* for projectiles that travel in straight lines */
-void UpdateProjectile(Entity *proj) {
-    proj->x += proj->speed * cos(proj->angle);
-    proj->y += proj->speed * sin(proj->angle);
+/* for projectiles that travel in straight lines. checks the whole path it
+   covers this tick, so fast ones can't skip over an enemy, and hits what's
+   on it in order until it runs out of hits.
+
+   the move itself is IntegrateProjectiles, one pass over the whole pool
+   afterwards. one that hit something is left a step short of where it
+   ends up, so that pass takes it the rest of the way */
+void UpdateProjectile(Game *game, Entity *proj) {
+    Vector2 motion = { proj->vx, proj->vy };
+    Entity *target;
+
+    if (!SweepProjectile(game, proj, &motion, &target)) {
+        return;
+    }
+    do {
+        ProjectileHit(game, proj, target, &motion);
+    } while (proj->hits_left > 0 && SweepProjectile(game, proj, &motion, &target));
+
+    proj->x += motion.x - proj->vx;
+    proj->y += motion.y - proj->vy;
 }
 
-void DrawBullet(Entity *bullet) {
+void DrawBullet(Game *game, Entity *bullet) {
+    // which way it's going, from the velocity so there's no trig per bullet
+    float dx = bullet->vx / bullet->speed, dy = bullet->vy / bullet->speed;
+    (void) game;
     DrawLineEx(
-        (Vector2){bullet->x - bullet->size * cos(bullet->angle), bullet->y - bullet->size * sin(bullet->angle)},
-        (Vector2){bullet->x + bullet->size * cos(bullet->angle), bullet->y + bullet->size * sin(bullet->angle)},
+        (Vector2){bullet->x - bullet->size * dx, bullet->y - bullet->size * dy},
+        (Vector2){bullet->x + bullet->size * dx, bullet->y + bullet->size * dy},
         4.0f, DARKGRAY
     );
     DrawLineEx(
-        (Vector2){bullet->x - bullet->size * 3/4 * cos(bullet->angle), bullet->y - bullet->size * 3/4 * sin(bullet->angle)},
-        (Vector2){bullet->x + bullet->size * 3/4 * cos(bullet->angle), bullet->y + bullet->size * 3/4 * sin(bullet->angle)},
+        (Vector2){bullet->x - bullet->size * 3/4 * dx, bullet->y - bullet->size * 3/4 * dy},
+        (Vector2){bullet->x + bullet->size * 3/4 * dx, bullet->y + bullet->size * 3/4 * dy},
         2.0f, BLACK
     );
 }
 
-void DrawShell(Entity *shell) {
-    DrawCircle(shell->x, shell->y, shell->size, ORANGE);
-    DrawCircle(shell->x, shell->y, shell->size * 5/6, RED);
+void DrawShell(Game *game, Entity *shell) {
+    DrawCircleQ(game, shell->x, shell->y, shell->size, ORANGE);
+    DrawCircleQ(game, shell->x, shell->y, shell->size * 5/6, RED);
+}
+
+void DrawSpike(Game *game, Entity *spike) {
+    float dx = spike->vx / spike->speed, dy = spike->vy / spike->speed;
+    (void) game;
+    DrawLineEx(
+        (Vector2){spike->x - spike->size * 2 * dx, spike->y - spike->size * 2 * dy},
+        (Vector2){spike->x + spike->size * dx, spike->y + spike->size * dy},
+        3.0f, DARKBLUE
+    );
+}
+
+void DrawArc(Game *game, Entity *arc) {
+    DrawCircleQ(game, arc->x, arc->y, arc->size, SKYBLUE);
+    DrawCircleQ(game, arc->x, arc->y, arc->size / 2, WHITE);
 }
 
 
 /* game ui elements */
 
-void DrawGameUI(void) {
-    DisplayPlayerHP();
-    DisplayGameTime();
+void DrawGameUI(Game *game) {
+    DisplayPlayerHP(game);
+    DisplayGameTime(game);
+    DisplayXP(game);
+    if (game->show_metrics) {
+        DisplayMetrics(game);
+    }
 }
 
-void DisplayPlayerHP(void) {
+void DisplayPlayerHP(Game *game) {
 
     /* don't draw if player is at full health */
-    if (game.player.hp == game.player.max_hp) {
+    if (game->player.hp == game->player.max_hp) {
         return;
     }
 
@@ -637,27 +1196,49 @@ void DisplayPlayerHP(void) {
         (Color){ 33, 152, 3, 255 },
         (Color){ 24, 150, 2, 255 },
     };
-    int proportion = (int) (40 * game.player.hp / game.player.max_hp);
+    int proportion = (int) (40 * game->player.hp / game->player.max_hp);
     int width = 1;
-    DrawRectangle(game.player.x - 21, game.player.y - 26, 42, 7, BLACK);
-    DrawRectangle(game.player.x - 20, game.player.y - 25, width * proportion, 5, gradient[proportion]);
+    DrawRectangle(game->player.x - 21, game->player.y - 26, 42, 7, BLACK);
+    DrawRectangle(game->player.x - 20, game->player.y - 25, width * proportion, 5, gradient[proportion]);
 }
 
-void DisplayGameTime(void) {
-    int secs = (int) game.ui.gametime;
+void DisplayGameTime(Game *game) {
+    int secs = (int) game->ui.gametime;
     int h = secs / 3600;
     int m = (secs / 60) % 60;
     int s = secs % 60;
     char time_str[30];
     if (h > 0) {
         sprintf(time_str, "%02d:%02d:%02d", h, m, s);
-        DrawTextUI(time_str, 94, 5, 20, BLACK);
+        DrawTextUI(screen_view(game), time_str, 94, 5, 20, BLACK);
     } else {
         sprintf(time_str, "%02d:%02d", m, s);
-        DrawTextUI(time_str, 95, 5, 20, BLACK);
+        DrawTextUI(screen_view(game), time_str, 95, 5, 20, BLACK);
     }
 }
 
+void DisplayXP(Game *game) {
+    char xp_str[30];
+    sprintf(xp_str, "XP %d", game->xp);
+    DrawTextUI(screen_view(game), xp_str, 50, 5, 20, BLACK);
+}
+
+/* quality governor metrics, top left */
+void DisplayMetrics(Game *game) {
+    char metrics_str[64];
+    TextureCacheStats *tex = &game->textures.cache->stats;
+
+    sprintf(metrics_str, "quality %s  headroom %d%%", QualityName(game->quality.level), (int) (game->quality.headroom * 100));
+    DrawTextUI(screen_view(game), metrics_str, 16, 5, 20, BLACK);
+    sprintf(metrics_str, "textures %d (%zu kB)  miss %d  evict %d", tex->count, tex->bytes / 1024, tex->misses, tex->evictions);
+    DrawTextUI(screen_view(game), metrics_str, 16, 9, 20, BLACK);
+    sprintf(metrics_str, "minimap %d us splat  %d us upload", (int) (game->minimap.splat_secs * 1e6), (int) (game->minimap.upload_secs * 1e6));
+    DrawTextUI(screen_view(game), metrics_str, 16, 13, 20, BLACK);
+    sprintf(metrics_str, "burning %d  frozen %d  poisoned %d",
+        game->status[STATUS_BURN].count, game->status[STATUS_FROZEN].count, game->status[STATUS_POISON].count);
+    DrawTextUI(screen_view(game), metrics_str, 16, 17, 20, BLACK);
+}
+
 /* entity methods */
 
 Rectangle EntityHitbox(Entity e) {
@@ -670,13 +1251,19 @@ Rectangle EntityHitbox(Entity e) {
     }
 }
 
-void DrawEntities(bool update) {
-    EntityVec *entlist, *targetlist;
-    Entity *e, *target;
+void UpdateEntities(Game *game) {
+    EntityVec *entlist;
+    Entity *e;
 
     // for each type of entity
     for (int etype = 0; etype < E_COUNT; etype++) {
-        entlist = &game.entities[etype];
+        /* enemies come first in EntityType, so they've all moved by now */
+        if (etype == E_PLAYER_BULLET) {
+            BuildEnemyGrid(game);
+            MergeEnemies(game);
+        }
+
+        entlist = &game->entities[etype];
         if (vec_empty(entlist))
             continue;
 
@@ -686,171 +1273,471 @@ void DrawEntities(bool update) {
 
             switch (etype) {
                 
-                /* draw projectiles first, then the enemies they hit */
+                /* projectiles first, then the enemies they hit */
                 case E_PLAYER_BULLET: 
-                case E_PLAYER_SHELL: {
-                    e = &entlist->data[i];
-                    if (entity_offscreen(*e)) {
-                        if (update) {
-                            vec_remove(entlist, i);
-                            i--;
-                        }
-                    } else {
-                        
-                        if (update) {
-
-                            // check for any collisions with enemies
-                            for (int etype_index = 0; etype_index < len(game.config.enemy_types); etype_index++) {
-                                targetlist = &game.entities[game.config.enemy_types[etype_index]];
-                                for (int j = 0; j < targetlist->length; j++) {
-                                    target = &targetlist->data[j];
-                                    if (is_collision(*e, *target)) {
-                                        target->hp -= e->contact_damage;
-
-                                        /* only shells spawn explosions, not bullets */
-                                        if (etype == E_PLAYER_SHELL) {
-                                            SpawnPExplosion(e->x, e->y);
-                                        }
-
-                                        if (target->hp <= 0) {
-                                            SpawnPEnemyFadeout(target);
-                                            // remove target
-                                            vec_remove(targetlist, j);
-                                            j--;
-                                        }
-
-                                        // remove projectile
-                                        vec_remove(entlist, i);
-                                        i--;
-
-                                        continue;
-                                    }
-                                }
-                                UpdateEntity(e);
-                            }                            
-                        }
+                case E_PLAYER_SHELL:
+                case E_PLAYER_SPIKE:
+                case E_PLAYER_ARC: {
+                    if (entity_offscreen(game, *e)) {
+                        vec_remove(entlist, i);
+                        i--;
+                        break;
                     }
-                    DrawEntity(e);
-                    if (show_hitboxes) {
-                        DrawEntityHitbox(e);
+
+                    // does the hitting, see UpdateProjectile
+                    UpdateEntity(game, e);
+                    if (e->hits_left <= 0) {
+                        // remove projectile
+                        vec_remove(entlist, i);
+                        i--;
                     }
-                    
                     break;
                 }
 
-                break;
-                
                 case E_ENEMY_BASIC:
-                case E_ENEMY_LARGE: {
-                    
-                    if (update) {
-                        // if two enemies (of the same type) have the "same" xy pos, remove one
-                        targetlist = &game.entities[e->type];
-                        if (vec_empty(targetlist)) {
-                            break;
-                        }
-                        for (int j = 0; j < targetlist->length; j++) {
-                            target = &targetlist->data[j];
-
-                            if (i == j)
-                                continue;
-
-                            /* optimization - enemy merging - keep it like this */
-                            if (entity_distance(*e, *target) < 0.5) {
-                                // remove other
-                                vec_remove(targetlist, j);
-                                j--;
-                            }
-
-                            if (is_collision(game.player, *e)) {
-                                DamagePlayer(e->contact_damage);
-                            }
-                        }
-                        UpdateEntity(e);
-                    }
-
-                    DrawEntity(e);
-                    if (show_hitboxes) {
-                        DrawEntityHitbox(e);
+                case E_ENEMY_LARGE:
+                case E_ENEMY_RANGED: {
+                    if (is_collision(game->player, *e)) {
+                        DamagePlayer(game, e->contact_damage);
                     }
-
+                    UpdateEntity(game, e);
                     break;
                 }
                 default: break;
             }
         }
+
+        // the ones above did the hitting, this does the moving
+        if (getattr(etype, update) == UpdateProjectile) {
+            IntegrateProjectiles(entlist);
+        }
     }
 }
 
-void DrawParticles(bool update) {
-    EntityVec ev;
+/* files every enemy in enemy_grid. the grid covers the spawn ring, so
+   nearly everything lands in a cell of its own area */
+void BuildEnemyGrid(Game *game) {
+    float w = game->config.screen_margin[1] * screensize(game).x/2;
+    float h = game->config.screen_margin[1] * screensize(game).y/2;
+    EntityVec *ev;
+    EntityType type;
+
+    BeginSpatialGrid(&game->enemy_grid, (Rectangle){ game->player.x - w, game->player.y - h, 2*w, 2*h });
+    for (int etype_index = 0; etype_index < len(game->config.enemy_types); etype_index++) {
+        type = game->config.enemy_types[etype_index];
+        ev = &game->entities[type];
+        for (int j = 0; j < ev->length; j++) {
+            SpatialAdd(&game->enemy_grid, (SpatialRef){ type, j }, EntityHitbox(ev->data[j]));
+        }
+    }
+    EndSpatialGrid(&game->enemy_grid);
+}
+
+/* if two enemies of the same type have the "same" xy pos, one goes. over
+   budget the director widens "same" to merge_radius and the one that goes
+   is absorbed into the other, so there are fewer but tougher enemies.
+
+   each one asks enemy_grid what's near it, so it's the neighbours that
+   get compared and not every pair. the ones that go are only marked
+   (hp 0) since the grid still points at them, RemoveDeadEnemies takes
+   them out with the ones killed this tick */
+void MergeEnemies(Game *game) {
+    float radius = fmaxf(0.5, game->director.merge_radius), dist;
+    EntityType type;
+    EntityVec *ev;
+    Entity *e, *other;
+    SpatialRef *refs;
+    int count;
+
+    for (int etype_index = 0; etype_index < len(game->config.enemy_types); etype_index++) {
+        type = game->config.enemy_types[etype_index];
+        ev = &game->entities[type];
+        for (int i = 0; i < ev->length; i++) {
+            e = &ev->data[i];
+            if (e->hp <= 0) {
+                continue;
+            }
+            refs = SpatialQueryNear(&game->enemy_grid, (Vector2){ e->x, e->y }, radius, &count);
+            for (int k = 0; k < count; k++) {
+                // only look ahead, so each pair is looked at once
+                if (refs[k].type != (int) type || refs[k].index <= i) {
+                    continue;
+                }
+                other = &ev->data[refs[k].index];
+                if (other->hp <= 0 || (dist = entity_distance(*e, *other)) >= radius) {
+                    continue;
+                }
+                if (dist >= 0.5) {
+                    AbsorbEnemy(game, e, other);
+                }
+                other->hp = 0;
+            }
+        }
+    }
+}
+
+/* x += vx for a whole pool at once. nothing in here but the adds, so it's
+   one tight loop over contiguous memory */
+void IntegrateProjectiles(EntityVec *ev) {
+    Entity *restrict e = ev->data;
+    int n = ev->length;
+
+    for (int i = 0; i < n; i++) {
+        e[i].x += e[i].vx;
+        e[i].y += e[i].vy;
+    }
+}
+
+/* every hit on an enemy goes through here */
+void DamageEnemy(Game *game, Entity *target, int amount) {
+    target->hp -= amount;
+    ShowDamage(game, target->id, target->x, target->y - target->size, amount);
+    if (target->hp <= 0) {
+        KillEnemy(game, target);
+    }
+}
+
+/* target just went to 0 hp. it's left where it is (the grid still points
+   at it) and RemoveDeadEnemies takes it out */
+void KillEnemy(Game *game, Entity *target) {
+    EntityAttrs *attrs = &game->config.entitydata[target->type];
+
+    SpawnPEnemyFadeout(game, target);
+    // tougher ones (director, merging) are worth more
+    DropGem(game, target->x, target->y, attrs->xp * fmaxf(1, (float) target->max_hp / attrs->max_hp));
+}
+
+/* vec_remove for anything that could have a status effect on it, so the
+   status lists can let go of it and follow the one moved into its place */
+void RemoveEntity(Game *game, EntityType type, int index) {
+    ForgetStatus(game, type, index);
+    vec_remove(&game->entities[type], index);
+}
+
+/* enemies killed while the grid was in use are only marked (hp <= 0) so
+   its indices stay valid, this takes them out afterwards */
+void RemoveDeadEnemies(Game *game) {
+    EntityVec *ev;
+
+    for (int etype_index = 0; etype_index < len(game->config.enemy_types); etype_index++) {
+        ev = &game->entities[game->config.enemy_types[etype_index]];
+        // backwards, so whatever vec_remove swaps in has been looked at already
+        for (int j = ev->length - 1; j >= 0; j--) {
+            if (ev->data[j].hp <= 0) {
+                RemoveEntity(game, game->config.enemy_types[etype_index], j);
+            }
+        }
+    }
+}
+
+/* the first live enemy proj hasn't hit yet that it touches while moving
+   by motion. if there is one proj is moved up to the point of contact and
+   motion becomes what's left of it. enemies are treated as still, they
+   move a fraction of what projectiles do */
+bool SweepProjectile(Game *game, Entity *proj, Vector2 *motion, Entity **hit) {
+    Rectangle box = EntityHitbox(*proj);
+    SpatialRef *refs;
     Entity *target;
+    float t, first = 1;
+    int count;
+
+    *hit = NULL;
+    refs = SpatialQuery(&game->enemy_grid, SweptBounds(box, *motion), &count);
+    for (int k = 0; k < count; k++) {
+        target = &game->entities[refs[k].type].data[refs[k].index];
+        // killed earlier this tick, or it's been through this one already
+        if (target->hp <= 0 || HitListHas(&proj->hits, target->id)) {
+            continue;
+        }
+        if (SweepRects(box, *motion, EntityHitbox(*target), &t) && (*hit == NULL || t < first)) {
+            first = t;
+            *hit = target;
+        }
+    }
+
+    if (*hit != NULL) {
+        proj->x += motion->x * first;
+        proj->y += motion->y * first;
+        motion->x *= 1 - first;
+        motion->y *= 1 - first;
+    }
+    return *hit != NULL;
+}
+
+/* proj just touched target. chaining ones turn towards the nearest enemy
+   within chain_radius they haven't hit, and are spent if there isn't one */
+void ProjectileHit(Game *game, Entity *proj, Entity *target, Vector2 *motion) {
+    float radius = getattr(proj->type, chain_radius);
+    float dist, nearest = radius, left;
+    Entity *next = NULL, *other;
+    SpatialRef *refs;
+    int count;
+
+    DamageEnemy(game, target, proj->contact_damage);
+    InflictStatus(game, target, getattr(proj->type, inflicts));
+
+    /* only shells spawn explosions, not bullets */
+    if (proj->type == E_PLAYER_SHELL) {
+        SpawnPExplosion(game, proj->x, proj->y);
+    }
+
+    proj->hits.ids[proj->hits.count++] = target->id;
+    proj->hits_left--;
+
+    if (proj->hits_left <= 0 || getattr(proj->type, chain) <= 0) {
+        return;
+    }
+
+    refs = SpatialQueryCircle(&game->enemy_grid, (Vector2){ proj->x, proj->y }, radius, &count);
+    for (int k = 0; k < count; k++) {
+        other = &game->entities[refs[k].type].data[refs[k].index];
+        if (other->hp <= 0 || HitListHas(&proj->hits, other->id)) {
+            continue;
+        }
+        if ((dist = entity_distance(*proj, *other)) < nearest) {
+            nearest = dist;
+            next = other;
+        }
+    }
+
+    if (next == NULL) {
+        proj->hits_left = 0;
+        return;
+    }
+    left = sqrtf(motion->x * motion->x + motion->y * motion->y);
+    proj->angle = entity_angle(*proj, *next);
+    proj->vx = proj->speed * cos(proj->angle);
+    proj->vy = proj->speed * sin(proj->angle);
+    motion->x = left / proj->speed * proj->vx;
+    motion->y = left / proj->speed * proj->vy;
+}
+
+bool HitListHas(HitList *list, unsigned int id) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->ids[i] == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DrawEntities(Game *game) {
+    EntityVec *entlist;
+
+    for (int etype = 0; etype < E_COUNT; etype++) {
+        entlist = &game->entities[etype];
+        for (int i = 0; i < entlist->length; i++) {
+            DrawEntity(game, &entlist->data[i]);
+            if (game->show_hitboxes && QualitySetting(game)->hitboxes) {
+                DrawEntityHitbox(&entlist->data[i]);
+            }
+        }
+    }
+}
+
+/* damage is done by the particle's AreaDamage, see UpdateAreaDamage */
+void UpdateParticles(Game *game) {
     Particle *p;
     for (int ptype = 0; ptype < P_COUNT; ptype++) {
-        if (vec_empty(&game.particles[ptype])) {
-            continue;
+        for (int i = 0; i < game->particles[ptype].length; i++) {
+            p = &game->particles[ptype].data[i];
+            UpdateParticle(game, p);
+
+            p->currframe++;
+            if (ParticleDone(*p)) {
+                vec_remove(&game->particles[ptype], i);
+                i--;
+                continue;
+            }
         }
-        for (int i = 0; i < game.particles[ptype].length; i++) {
-            p = &game.particles[ptype].data[i];
-            DrawParticle(p, update);
-            if (show_hitboxes) {
+    }
+
+}
+
+void DrawParticles(Game *game) {
+    Particle *p;
+    for (int ptype = 0; ptype < P_COUNT; ptype++) {
+        for (int i = 0; i < game->particles[ptype].length; i++) {
+            p = &game->particles[ptype].data[i];
+            DrawParticle(game, p);
+            if (game->show_hitboxes && QualitySetting(game)->hitboxes) {
                 DrawParticleHitbox(p);
             }
+        }
+    }
+}
 
-            if (update) {
-                if (p->damage >= 0) {
-                    for (int etype_index = 0; etype_index < len(game.config.enemy_types); etype_index++) {
-                        ev = game.entities[game.config.enemy_types[etype_index]];
-                        if (vec_empty(&ev)) {
-                            continue;
-                        }
-
-                        for (int j = 0; j < ev.length; j++) {
-                            if (i == j) {
-                                continue;
-                            }
-
-                            target = &ev.data[j];
-                            if (is_p_collision(*p, *target)) {
-                                target->hp -= p->damage;
-
-                                if (target->hp <= 0) {
-                                    SpawnPEnemyFadeout(target);
-                                    // remove target
-                                    vec_remove(&ev, j);
-                                    j--;
-                                    continue;
-                                }
-                            }
-                        }
-                    }
-                }
+/* scales max_counts down to fit storage_budget and allocates every vec at
+   its max up front, so storage never grows or moves during a game */
+void ReserveStorage(Game *game) {
+    size_t total = 0;
+    float scale;
 
-                if (ParticleDone(*p)) {
-                    vec_remove(&game.particles[ptype], i);
-                    i--;
-                    continue;
+    for (int i = 0; i < E_COUNT; i++) {
+        total += (size_t) game->config.entitydata[i].max_count * sizeof(Entity);
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        total += (size_t) game->config.particledata[i].max_count * sizeof(Particle);
+    }
+    total += (size_t) game->config.max_areas * sizeof(AreaDamage);
+    total += (size_t) game->config.hostile.max_shots * HOSTILE_SHOT_SIZE;
+    total += (size_t) (game->config.gems.max_gems + GEM_MAX_PULLED) * sizeof(Gem);
+
+    if (total > game->config.storage_budget) {
+        scale = (float) game->config.storage_budget / total;
+        fprintf(stderr, "Entity caps need %zu bytes, scaling them to %d%% to fit in %zu\n",
+            total, (int) (scale * 100), game->config.storage_budget);
+        for (int i = 0; i < E_COUNT; i++) {
+            game->config.entitydata[i].max_count *= scale;
+        }
+        for (int i = 0; i < P_COUNT; i++) {
+            game->config.particledata[i].max_count *= scale;
+        }
+        game->config.max_areas *= scale;
+        game->config.hostile.max_shots *= scale;
+        game->config.gems.max_gems *= scale;
+    }
+
+    for (int i = 0; i < E_COUNT; i++) {
+        vec_reserve(&game->entities[i], game->config.entitydata[i].max_count);
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        vec_reserve(&game->particles[i], game->config.particledata[i].max_count);
+    }
+    vec_reserve(&game->areas, game->config.max_areas);
+    for (int i = 0; i < E_COUNT; i++) {
+        vec_reserve(&game->evicting, game->config.entitydata[i].max_count);
+    }
+    // a few volleys, it only grows if a tick is further behind than that
+    vec_reserve(&game->volleys, 4 * WEAPON_MAX_SHOTS);
+    game->area_hits = MemAlloc(game->config.max_areas * sizeof(HitSet));
+    for (int i = 0; i < game->config.max_areas; i++) {
+        vec_init(&game->area_hits[i]);
+    }
+}
+
+/* see EvictCandidate */
+static double eviction_key(Game *game, Entity *e, EvictPolicy policy) {
+    switch (policy) {
+        case EVICT_FARTHEST:    return entity_distance(game->player, *e);
+        case EVICT_OLDEST:
+        default:                return -(double) e->id;
+    }
+}
+
+/* h is a min-heap by key of n */
+static void evict_sift_down(EvictCandidate *h, int n, int i) {
+    EvictCandidate swap;
+    int child;
+
+    while ((child = 2 * i + 1) < n) {
+        if (child + 1 < n && h[child + 1].key < h[child].key) {
+            child++;
+        }
+        if (h[i].key <= h[child].key) {
+            break;
+        }
+        swap = h[i];
+        h[i] = h[child];
+        h[child] = swap;
+        i = child;
+    }
+}
+
+static int by_index_descending(const void *a, const void *b) {
+    return ((const EvictCandidate *) b)->index - ((const EvictCandidate *) a)->index;
+}
+
+/* the count entities to make room by, in one pass over ev. the ones kept
+   so far are a min-heap, so the root is the one to let off when something
+   more deserving comes along. they come back highest index first, so
+   removing them in order never swaps one into a hole that's still to go */
+static EvictCandidate *entities_to_evict(Game *game, EntityVec *ev, EvictPolicy policy, int count) {
+    EvictCandidate *h = game->evicting.data;
+    double key;
+
+    for (int i = 0; i < ev->length; i++) {
+        key = eviction_key(game, &ev->data[i], policy);
+        if (i < count) {
+            h[i] = (EvictCandidate){ key, i };
+            if (i == count - 1) {
+                for (int j = count / 2 - 1; j >= 0; j--) {
+                    evict_sift_down(h, count, j);
                 }
             }
+        } else if (key > h[0].key) {
+            h[0] = (EvictCandidate){ key, i };
+            evict_sift_down(h, count, 0);
         }
     }
+    qsort(h, count, sizeof(*h), by_index_descending);
+    return h;
+}
 
+/* gives the entity its id and puts it in its type's vec */
+void AddEntity(Game *game, Entity e) {
+    AddEntities(game, &e, 1);
 }
 
-Entity RandSpawnEnemy(EntityType type) {
+/* AddEntity for a batch of the same type: makes room once, then the lot
+   goes in with one copy. under EVICT_FARTHEST the new ones take turns
+   absorbing the ones that made room */
+void AddEntities(Game *game, Entity *es, int count) {
+    EntityType type;
+    EntityVec *ev;
+    EvictPolicy policy;
+    int max, over;
+    EvictCandidate *victims;
+
+    if (count <= 0) {
+        return;
+    }
+    type = es[0].type;
+    ev = &game->entities[type];
+    policy = getattr(type, evict);
+    max = getattr(type, max_count);
+    // more than fits at all, only the last max of them matter
+    if (count > max) {
+        es += count - max;
+        count = max;
+    }
+    if ((over = ev->length + count - max) > 0) {
+        victims = entities_to_evict(game, ev, policy, over);
+        for (int i = 0; i < over; i++) {
+            if (policy == EVICT_FARTHEST) {
+                AbsorbEnemy(game, &es[i % count], &ev->data[victims[i].index]);
+            }
+            RemoveEntity(game, type, victims[i].index);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        es[i].id = game->next_id++;
+    }
+    vec_pusharr(ev, es, count);
+}
+
+/* e takes other's hp and some of its size, other is about to be removed */
+void AbsorbEnemy(Game *game, Entity *e, Entity *other) {
+    e->max_hp += other->max_hp;
+    e->hp += other->hp;
+    e->size = fminf(sqrtf(e->size * e->size + other->size * other->size), getattr(e->type, size) * DIRECTOR_MAX_GROWTH);
+}
+
+Entity RandSpawnEnemy(Game *game, EntityType type) {
     float x, y;
 
-    x = randrange(game.player.x - (game.config.screen_margin[1] * GetScreenWidth()/2), game.player.x + (game.config.screen_margin[1] + GetScreenWidth()/2));
+    x = randrange(game, game->player.x - (game->config.screen_margin[1] * screensize(game).x/2), game->player.x + (game->config.screen_margin[1] + screensize(game).x/2));
 
-    if (game.player.x - (game.config.screen_margin[0] * GetScreenWidth()/2) <= x && x <= game.player.x + (game.config.screen_margin[0] * GetScreenWidth()/2)) {
+    if (game->player.x - (game->config.screen_margin[0] * screensize(game).x/2) <= x && x <= game->player.x + (game->config.screen_margin[0] * screensize(game).x/2)) {
         // if x position is on the screen, y pos should be offscreen
         y = cointoss(
-            randrange(game.player.y - (game.config.screen_margin[1] * GetScreenHeight()/2), game.player.y - (game.config.screen_margin[0] * GetScreenHeight()/2)),
-            randrange(game.player.y + (game.config.screen_margin[0] * GetScreenHeight()/2), game.player.y + (game.config.screen_margin[1] * GetScreenHeight()/2))
+            randrange(game, game->player.y - (game->config.screen_margin[1] * screensize(game).y/2), game->player.y - (game->config.screen_margin[0] * screensize(game).y/2)),
+            randrange(game, game->player.y + (game->config.screen_margin[0] * screensize(game).y/2), game->player.y + (game->config.screen_margin[1] * screensize(game).y/2))
         );
     } else {
         // otherwise, y can be anywhere
-        y = randrange(game.player.y - (game.config.screen_margin[1] * GetScreenHeight()/2), game.player.y + (game.config.screen_margin[1] * GetScreenHeight()/2));
+        y = randrange(game, game->player.y - (game->config.screen_margin[1] * screensize(game).y/2), game->player.y + (game->config.screen_margin[1] * screensize(game).y/2));
     }
 
     // printf("spawning at (%f, %f)\n", x, y);
@@ -868,55 +1755,34 @@ Entity RandSpawnEnemy(EntityType type) {
     };
 }
 
-/* Fires at direction of closest enemy and keeps going in that direction (not homing bullets) */
-Entity PlayerFireBullet(void) {
-    Entity *p = player_closest_enemy();
-    if (p == NULL) {
-        // no enemies to shoot at, so don't fire any bullets
-        // NONE means it's invalid
-        return (Entity) {
-            .type = E_NONE
-        };
-    }
-    return (Entity) {
-        .type = E_PLAYER_BULLET,
-        .x = game.player.x,
-        .y = game.player.y,
-        .size = getattr(E_PLAYER_BULLET, size),
-        .speed = getattr(E_PLAYER_BULLET, speed),
-        .angle = entity_angle(game.player, *p),
-        .contact_damage = getattr(E_PLAYER_BULLET, contact_damage),
-        .spawned_particle = false,
-    };
-}
-
-/* Fires at the mouse cursor and keeps going that way */
-Entity PlayerFireShell(void) {
+/* a projectile of type leaving the player at angle, with its velocity
+   worked out. it isn't added anywhere, see weapons.c */
+Entity NewProjectile(Game *game, EntityType type, float angle) {
     return (Entity) {
-        .type = E_PLAYER_SHELL,
-        .x = game.player.x,
-        .y = game.player.y,
-        .size = getattr(E_PLAYER_SHELL, size),
-        .speed = getattr(E_PLAYER_SHELL, speed),
-        .angle = vec_angle(
-            (Vector2){ game.player.x, game.player.y }, 
-            (Vector2){ GraphicsGetScreenOffset().x + GetMouseX(), GraphicsGetScreenOffset().y + GetMouseY() }
-        ),
-        .contact_damage = getattr(E_PLAYER_SHELL, contact_damage),
+        .type = type,
+        .x = game->player.x,
+        .y = game->player.y,
+        .size = getattr(type, size),
+        .speed = getattr(type, speed),
+        .angle = angle,
+        .vx = getattr(type, speed) * cos(angle),
+        .vy = getattr(type, speed) * sin(angle),
+        .contact_damage = getattr(type, contact_damage),
         .spawned_particle = false,
+        .hits_left = fminf(1 + getattr(type, pierce) + getattr(type, chain), ENTITY_MAX_HITS),
     };
 }
 
-void MoveEntityToPlayer(Entity *e) {
+void MoveEntityToPlayer(Game *game, Entity *e) {
     double dist_to_player;
     Vector2 v;
 
     dist_to_player = sqrt(
-        pow(game.player.x - e->x, 2) + 
-        pow(game.player.y - e->y, 2)
+        pow(game->player.x - e->x, 2) + 
+        pow(game->player.y - e->y, 2)
     );
 
-    v = (Vector2){game.player.x - e->x, game.player.y - e->y};
+    v = (Vector2){game->player.x - e->x, game->player.y - e->y};
     v.x /= dist_to_player;
     v.y /= dist_to_player;
     e->x += (v.x * e->speed);
@@ -933,20 +1799,41 @@ void DrawParticleHitbox(Particle *p) {
     DrawRectangleLinesEx(ParticleHitbox(*p), 1.0, BLACK);
 }
 
-void SpawnParticle(ParticleType type, float x, float y) {
-    vec_push(&game.particles[type], NewParticle(type, x, y));
+void SpawnParticle(Game *game, ParticleType type, float x, float y) {
+    ParticleVec *pv = &game->particles[type];
+    int oldest;
+
+    while (pv->length > 0 && pv->length >= game->config.particledata[type].max_count) {
+        if (game->config.particledata[type].cosmetic) {
+            return;
+        }
+        oldest = 0;
+        for (int i = 1; i < pv->length; i++) {
+            if (pv->data[i].currframe > pv->data[oldest].currframe) {
+                oldest = i;
+            }
+        }
+        vec_remove(pv, oldest);
+    }
+
+    vec_push(pv, NewParticle(game, type, x, y));
+    if (game->config.particledata[type].damage > 0) {
+        AddAreaDamage(game, type, x, y);
+    }
+    if (game->recorder != NULL) {
+        RecordParticleSpawn(game->recorder, type, x, y);
+    }
 }
 
-Particle NewParticle(ParticleType type, float x, float y) {
+Particle NewParticle(Game *game, ParticleType type, float x, float y) {
     return (Particle) {
         .type = type,
         .x = x,
         .y = y,
-        .starting_size = game.config.particledata[type].starting_size,
-        .size = game.config.particledata[type].starting_size,
-        .lifetime = game.config.particledata[type].lifetime,
+        .starting_size = game->config.particledata[type].starting_size,
+        .size = game->config.particledata[type].starting_size,
+        .lifetime = game->config.particledata[type].lifetime,
         .currframe = 1,
-        .damage = game.config.particledata[type].damage,
     };
 }
 
@@ -957,79 +1844,206 @@ bool ParticleDone(Particle p) {
 
 /* generics */
 
-void DrawParticle(Particle *p, bool advance_frame) {
-    game.config.particledata[p->type].draw(p, advance_frame);
+void DrawParticle(Game *game, Particle *p) {
+    game->config.particledata[p->type].draw(game, p);
+}
+
+/* per-type animation, the frame counter is advanced by UpdateParticles */
+void UpdateParticle(Game *game, Particle *p) {
+    PUpdateFunc update = game->config.particledata[p->type].update;
+    if (update != NULL) {
+        update(p);
+    }
 }
 
-void SpawnPExplosion(float x, float y) {
-    SpawnParticle(P_EXPLOSION, x, y);
+void SpawnPExplosion(Game *game, float x, float y) {
+    SpawnParticle(game, P_EXPLOSION, x, y);
 }
 
-void SpawnPEnemyFadeout(Entity *target) {
+void SpawnPEnemyFadeout(Game *game, Entity *target) {
+    const QualitySettings *q = QualitySetting(game);
+    int alive = game->particles[P_ENEMY_FADEOUT_BASIC].length + game->particles[P_ENEMY_FADEOUT_LARGE].length;
+
+    /* purely cosmetic, first thing to go when frames are slow */
+    if ((q->fadeouts_per_tick >= 0 && game->quality.fadeouts_this_tick >= q->fadeouts_per_tick)
+        || (q->max_fadeouts >= 0 && alive >= q->max_fadeouts)) {
+        return;
+    }
+    game->quality.fadeouts_this_tick++;
+
     switch (target->type) {
-        case E_ENEMY_BASIC:     return SpawnParticle(P_ENEMY_FADEOUT_BASIC, target->x, target->y);
-        case E_ENEMY_LARGE:     return SpawnParticle(P_ENEMY_FADEOUT_LARGE, target->x, target->y);
+        case E_ENEMY_BASIC:     SpawnParticle(game, P_ENEMY_FADEOUT_BASIC, target->x, target->y); return;
+        case E_ENEMY_LARGE:     SpawnParticle(game, P_ENEMY_FADEOUT_LARGE, target->x, target->y); return;
+        case E_ENEMY_RANGED:    SpawnParticle(game, P_ENEMY_FADEOUT_BASIC, target->x, target->y); return;
         default:                return;
     }
 }
 
-void DrawPExplosion(Particle *exp, bool advance_frame) {
+void DrawPExplosion(Game *game, Particle *exp) {
+    DrawCircleQ(game, exp->x, exp->y, exp->size, YELLOW);
+}
+
+void UpdatePExplosion(Particle *exp) {
     exp->size = exp->currframe * exp->starting_size;
-    DrawCircle(exp->x, exp->y, exp->size, YELLOW);
-    if (advance_frame) {
-        exp->currframe++;
-    }
 }
 
-void DrawPEnemyFadeout(Particle *p, bool advance_frame) {
+void DrawPEnemyFadeout(Game *game, Particle *p) {
     int opacity = 255 - 25 * p->currframe;
     switch (p->type) {
         case P_ENEMY_FADEOUT_BASIC: {
-            DrawCircle(p->x, p->y, p->size, (Color){ 190, 33, 55, opacity });
-            DrawCircle(p->x, p->y, p->size * 2/3, (Color){ 230, 41, 55, opacity });
+            DrawCircleQ(game, p->x, p->y, p->size, (Color){ 190, 33, 55, opacity });
+            DrawCircleQ(game, p->x, p->y, p->size * 2/3, (Color){ 230, 41, 55, opacity });
             break;
         }
 
         case P_ENEMY_FADEOUT_LARGE: {
-            DrawCircle(p->x, p->y, p->size, (Color){ 0, 0, 0, opacity });
-            DrawCircle(p->x, p->y, p->size * 2/3, (Color){ 190, 33, 55, opacity });
+            DrawCircleQ(game, p->x, p->y, p->size, (Color){ 0, 0, 0, opacity });
+            DrawCircleQ(game, p->x, p->y, p->size * 2/3, (Color){ 190, 33, 55, opacity });
             break;
         }
         default: break;
     }
-    if (advance_frame) {
-        p->currframe++;
+}
+
+/* area damage */
+
+/* true if id wasn't in the set and now is. a full set doubles (from 64),
+   so an area hits everything it reaches however many that is */
+bool HitSetAdd(HitSet *set, unsigned int id) {
+    if (set->length == set->capacity) {
+        vec_reserve(set, set->capacity > 0 ? 2 * set->capacity : 64);
+    }
+    return InsertSortedId(set->data, &set->length, set->capacity, id);
+}
+
+/* same thing for any sorted array of ids with room for max */
+bool InsertSortedId(unsigned int *ids, int *count, int max, unsigned int id) {
+    int lo = 0, hi = *count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (ids[mid] < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if ((lo < *count && ids[lo] == id) || *count == max) {
+        return false;
+    }
+    memmove(&ids[lo + 1], &ids[lo], (*count - lo) * sizeof(*ids));
+    ids[lo] = id;
+    (*count)++;
+    return true;
+}
+
+/* goes along with a particle of type, and lives as long as it does */
+void AddAreaDamage(Game *game, ParticleType type, float x, float y) {
+    ParticleAttrs *attrs = &game->config.particledata[type];
+    int oldest;
+
+    if (game->config.max_areas <= 0) {
+        return;
+    }
+    if (game->areas.length >= game->config.max_areas) {
+        oldest = 0;
+        for (int i = 1; i < game->areas.length; i++) {
+            if (game->areas.data[i].frame > game->areas.data[oldest].frame) {
+                oldest = i;
+            }
+        }
+        RemoveAreaDamage(game, oldest);
+    }
+
+    vec_clear(&game->area_hits[game->areas.length]);
+    vec_push(&game->areas, ((AreaDamage){
+        .x = x,
+        .y = y,
+        .growth = attrs->starting_size,
+        .frame = 1,
+        .lifetime = attrs->lifetime,
+        .damage = attrs->damage,
+        .inflicts = attrs->inflicts,
+    }));
+}
+
+/* vec_remove, with its hit set going the same way as the area moved into
+   its place */
+void RemoveAreaDamage(Game *game, int index) {
+    int last = game->areas.length - 1;
+    HitSet hits = game->area_hits[index];
+
+    game->area_hits[index] = game->area_hits[last];
+    game->area_hits[last] = hits;
+    vec_remove(&game->areas, index);
+}
+
+/* each area asks enemy_grid what's inside its circle, so the cost goes with
+   how many enemies are in there and not how many there are. kills are only
+   marked, RemoveDeadEnemies takes them out */
+void UpdateAreaDamage(Game *game) {
+    AreaDamage *a;
+    SpatialRef *refs;
+    Entity *target;
+    int count;
+
+    for (int i = 0; i < game->areas.length; i++) {
+        a = &game->areas.data[i];
+        a->radius = a->frame * a->growth;
+
+        refs = SpatialQueryCircle(&game->enemy_grid, (Vector2){ a->x, a->y }, a->radius, &count);
+        for (int k = 0; k < count; k++) {
+            target = &game->entities[refs[k].type].data[refs[k].index];
+            if (target->hp <= 0 || !HitSetAdd(&game->area_hits[i], target->id)) {
+                continue;
+            }
+            DamageEnemy(game, target, a->damage);
+            InflictStatus(game, target, a->inflicts);
+        }
+
+        a->frame++;
+        if (a->frame >= a->lifetime) {
+            RemoveAreaDamage(game, i);
+            i--;
+        }
     }
 }
 
 /* general utils */
 
-Vector2 screensize(void) {
-    if (game.config.window_initialized) {
+Vector2 screensize(Game *game) {
+    if (game->config.window_initialized) {
         return (Vector2){ GetScreenWidth(), GetScreenHeight() };
     } else {
-        return game.config.window_init_dim;
+        return game->config.window_init_dim;
     }
 }
 
-Vector2 screen_offset(void) {
-    return (Vector2) { game.player.x - screensize().x/2, game.player.y - screensize().y/2 };
+Vector2 screen_offset(Game *game) {
+    return (Vector2) { game->player.x - screensize(game).x/2, game->player.y - screensize(game).y/2 };
+}
+
+/* what the ui methods in graphics.h draw into */
+Rectangle screen_view(Game *game) {
+    Vector2 offset = screen_offset(game);
+    Vector2 size = screensize(game);
+    return (Rectangle){ offset.x, offset.y, size.x, size.y };
 }
 
-int randrange(int min, int max) {
-    return min + rand() / (RAND_MAX / (max - min + 1) + 1);
+int randrange(Game *game, int min, int max) {
+    return min + rand_r(&game->rng) / (RAND_MAX / (max - min + 1) + 1);
 }
 
 // [min, max]
-float randfloat(float min, float max) {
-    float scale = rand() / (float) RAND_MAX; /* [0, 1.0] */
+float randfloat(Game *game, float min, float max) {
+    float scale = rand_r(&game->rng) / (float) RAND_MAX; /* [0, 1.0] */
     return min + scale * ( max - min );      /* [min, max] */
 }
 
 // bad idea (is this even used?)
-float randchoice(size_t count, float *probs, ...) {
+float randchoice(Game *game, size_t count, float *probs, ...) {
     va_list opts;
-    float r = randrange(0, count-1);
+    float r = randrange(game, 0, count-1);
     float ret;
     va_start(opts, probs);
     for (int i = 0; i <= r; i++) {
@@ -1054,13 +2068,13 @@ bool is_p_collision(Particle p, Entity e) {
     return CheckCollisionRecs(ParticleHitbox(p), EntityHitbox(e));
 }
 
-bool entity_offscreen(Entity e) {
-    float w = GetScreenWidth()/2;
-    float h = GetScreenHeight()/2;
-    return e.x < game.player.x - (game.config.screen_margin[0] * w)
-        || e.x > game.player.x + (game.config.screen_margin[0] * w)
-        || e.y < game.player.y - (game.config.screen_margin[0] * h)
-        || e.y > game.player.y + (game.config.screen_margin[0] * h);
+bool entity_offscreen(Game *game, Entity e) {
+    float w = screensize(game).x/2;
+    float h = screensize(game).y/2;
+    return e.x < game->player.x - (game->config.screen_margin[0] * w)
+        || e.x > game->player.x + (game->config.screen_margin[0] * w)
+        || e.y < game->player.y - (game->config.screen_margin[0] * h)
+        || e.y > game->player.y + (game->config.screen_margin[0] * h);
 }
 
 float entity_distance(Entity a, Entity b) {
@@ -1083,7 +2097,7 @@ float vec_angle(Vector2 a, Vector2 b) {
 }
 
 /* any type of enemy */
-Entity *player_closest_enemy(void) {
+Entity *player_closest_enemy(Game *game) {
 
     float smallest_dist = 10000.0, temp;
     int closest_index = -1;
@@ -1091,86 +2105,75 @@ Entity *player_closest_enemy(void) {
     EntityVec *entvec;
 
     EntityType etype;
-    for (int i = 0; i < len(game.config.enemy_types); i++) {
-        etype = game.config.enemy_types[i];
-        entvec = &game.entities[etype];
+    for (int i = 0; i < len(game->config.enemy_types); i++) {
+        etype = game->config.enemy_types[i];
+        entvec = &game->entities[etype];
         if (entvec->data == NULL){
             continue;
         }
         
         for (int j = 0; j < entvec->length; j++) {
 
-            if ((temp = entity_distance(game.player, entvec->data[j])) < smallest_dist) {
+            if ((temp = entity_distance(game->player, entvec->data[j])) < smallest_dist) {
 
                 smallest_dist = temp;
                 closest_index = j;
-                closest_type = i;
+                closest_type = etype;
                 continue;
             }
         }
     }
 
-    return (closest_type != E_NONE && closest_index != -1) ? &game.entities[closest_type].data[closest_index] : NULL;
+    return (closest_type != E_NONE && closest_index != -1) ? &game->entities[closest_type].data[closest_index] : NULL;
     
 }
 
+/* where cursor-aimed things go: input.aim, unless nothing is setting it
+   (headless without the bot), then the closest enemy like a bullet */
+Vector2 PlayerAim(Game *game) {
+    Entity *closest;
+
+    if (!game->headless || game->autopilot) {
+        return game->input.aim;
+    }
+    closest = player_closest_enemy(game);
+    return (closest != NULL)
+        ? (Vector2){ closest->x, closest->y }
+        : (Vector2){ game->player.x + 1, game->player.y };
+}
+
 /* a specified type */
-Entity *player_closest_entity(EntityType type) {
+Entity *player_closest_entity(Game *game, EntityType type) {
     float dist = 10000.0, temp;
-    int closest;
+    int closest = -1;
     
-    EntityVec *entvec = &game.entities[type];
+    EntityVec *entvec = &game->entities[type];
 
-    if (entvec->data == NULL){
-        return NULL;
-    }
-    
     for (int i = 0; i < entvec->length; i++) {
-        if ((temp = entity_distance(game.player, entvec->data[i])) < dist) {
+        if ((temp = entity_distance(game->player, entvec->data[i])) < dist) {
             dist = temp;
             closest = i;
             continue;
         }
     }
 
-    return &entvec->data[closest];
+    return (closest != -1) ? &entvec->data[closest] : NULL;
 }
 
 /* callbacks */
 
-void StartBtnCallback(void) {
-    SetState(GS_GAMEPLAY);
-}
-
-void RestartBtnCallback(void) {
-    SetState(GS_GAMEPLAY);
-}
-
-void BasicEnemySpawnTimerCallback(void) {
-    vec_push(&game.entities[E_ENEMY_BASIC], RandSpawnEnemy(E_ENEMY_BASIC));
-}
-
-void LargeEnemySpawnTimerCallback(void) {
-    vec_push(&game.entities[E_ENEMY_LARGE], RandSpawnEnemy(E_ENEMY_LARGE));
-}
-
-void PlayerInvincTimerCallback(void) {
-    game.player.invincible = false;
+void StartBtnCallback(void *ctx) {
+    SetState(ctx, GS_GAMEPLAY);
 }
 
-void PlayerBulletTimerCallback(void) {
-    Entity p = PlayerFireBullet();
-
-    // if no enemies to fire at, don't fire
-    if (p.type != E_NONE) {
-        vec_push(&game.entities[E_PLAYER_BULLET], p);
-    }
+void RestartBtnCallback(void *ctx) {
+    SetState(ctx, GS_GAMEPLAY);
 }
 
-void PlayerShellTimerCallback(void) {
-    vec_push(&game.entities[E_PLAYER_SHELL], PlayerFireShell());
+void PlayerInvincTimerCallback(void *ctx, int count, float late) {
+    Game *game = ctx;
+    (void) count;
+    (void) late;
+    game->player.invincible = false;
 }
 
-void DoNothingCallback(void) {
-    printf(":)\n");
-}
@@ -11,8 +11,26 @@
 #include "raylib.h"
 #include "vec.h"
 
+#include "assets.h"
+#include "bot.h"
+#include "director.h"
+#include "gems.h"
 #include "graphics.h"
+#include "hostile.h"
+#include "melee.h"
+#include "minimap.h"
+#include "numbers.h"
+#include "quality.h"
+#include "spatial.h"
+#include "startup.h"
+#include "status.h"
+#include "texcache.h"
 #include "timer.h"
+#include "weapons.h"
+
+#define len(arr) ((int)(sizeof(arr) / sizeof(*arr)))
+/* how long an idle screen sleeps between looking at the input, ms */
+#define IDLE_WAIT_MS 30
 
 typedef enum {
     /* invalid */
@@ -22,11 +40,17 @@ typedef enum {
 
     E_ENEMY_BASIC = 0,
     E_ENEMY_LARGE,
+    /* keeps its distance and shoots, see hostile.h */
+    E_ENEMY_RANGED,
 
     /* projectile types */
 
     E_PLAYER_BULLET,
     E_PLAYER_SHELL,
+    /* goes through enemies */
+    E_PLAYER_SPIKE,
+    /* jumps from enemy to enemy */
+    E_PLAYER_ARC,
 
     /* how many types there are, excluding player */
     E_COUNT,
@@ -35,15 +59,34 @@ typedef enum {
 
 } EntityType;
 
+/* the most enemies one projectile can hit */
+#define ENTITY_MAX_HITS 8
+
+/* ids of the enemies a projectile has hit, so piercing and chaining ones
+   never hit the same one twice. fixed size, every Entity carries one */
 typedef struct {
+    int count;
+    unsigned int ids[ENTITY_MAX_HITS];
+} HitList;
+
+typedef struct Entity {
     EntityType type;
+    /* unique for the whole run, set by AddEntity */
+    unsigned int id;
     float x, y;
     float size;
     float speed, angle;
+    // projectiles: speed along angle, per tick, worked out once when it's fired
+    float vx, vy;
     int max_hp, hp, contact_damage;
     bool invincible;
     // for explosions
     bool spawned_particle;
+    // enemies: slot + 1 in each effect's StatusList, 0 if it doesn't have it
+    unsigned short status[STATUS_COUNT];
+    // projectiles: how many more enemies it can hit, it's gone at 0
+    int hits_left;
+    HitList hits;
 } Entity;
 
 typedef enum {
@@ -66,9 +109,25 @@ typedef struct {
     int lifetime;
     // which frame it's on
     int currframe;
-    int damage;
 } Particle;
 
+/* ids of the enemies something has hit already, sorted. grows to hold
+   as many as it has to, so a crowd never runs it out */
+typedef vec_t(unsigned int) HitSet;
+
+/* damage over a growing circle that lands once on each enemy inside it.
+   particles with damage spawn one, the particle is just what it looks like */
+typedef struct {
+    float x, y;
+    float radius;
+    // radius is frame * growth, same as the particle's size
+    float growth;
+    int frame, lifetime;
+    int damage;
+    // STATUS_BITs it puts on them as well
+    unsigned int inflicts;
+} AreaDamage;
+
 typedef enum {
     GS_TITLE,
     GS_GAMEPLAY,
@@ -78,16 +137,38 @@ typedef enum {
 
 typedef vec_t(Entity) EntityVec;
 typedef vec_t(Particle) ParticleVec;
+typedef vec_t(AreaDamage) AreaDamageVec;
 
-typedef void (*EDrawFunc)(Entity*);
-typedef void (*EUpdateFunc)(Entity*);
+typedef struct Game Game;
+typedef struct Recorder Recorder;
+typedef struct FlightRecorder FlightRecorder;
+
+typedef void (*EDrawFunc)(Game*, Entity*);
+typedef void (*EUpdateFunc)(Game*, Entity*);
 
 // TODO: spawn and despawn?
-typedef void (*PDrawFunc)(Particle*, bool advance_frame);
+typedef void (*PDrawFunc)(Game*, Particle*);
+typedef void (*PUpdateFunc)(Particle*);
+
+/* what AddEntity does when a type is at its max_count */
+typedef enum {
+    /* lowest id goes */
+    EVICT_OLDEST = 0,
+    /* farthest from the player goes, and the new one takes its hp */
+    EVICT_FARTHEST,
+} EvictPolicy;
+
+/* an entity AddEntities might make room by, higher key goes first */
+typedef struct {
+    double key;
+    int index;
+} EvictCandidate;
 
 typedef struct {
     // in seconds
     float spawn_interval;
+    // for enemies, how spawn_interval tightens over time (see director.h)
+    SpawnCurve spawn_curve;
     // how often it spawns the thing, in seconds (0 = does not spawn it)
     float child_spawns[E_COUNT];
     // just for the player (sec)
@@ -98,8 +179,24 @@ typedef struct {
     float size;
     // unused for now
     float explosion_radius;
+    // projectiles: enemies it goes through after the first
+    int pierce;
+    // projectiles: times it turns towards the nearest enemy it hasn't hit yet
+    int chain;
+    float chain_radius;
+    // projectiles: STATUS_BITs it puts on what it hits
+    unsigned int inflicts;
+    // ranged enemies: seconds between shots at the player (0 = doesn't shoot),
+    // and how close it has to be. it stops walking a bit inside that
+    float shot_interval;
+    float shot_range;
+    // enemies: what the gem it drops is worth, times how much tougher than usual it was
+    int xp;
     int max_hp;
     int contact_damage;
+    // hard cap on how many can be alive, see ReserveStorage
+    int max_count;
+    EvictPolicy evict;
     EDrawFunc draw;
     EUpdateFunc update;
 } EntityAttrs;
@@ -107,25 +204,33 @@ typedef struct {
 typedef struct {
     float starting_size;
     int lifetime;
+    // to each enemy it touches, once (see AreaDamage)
     int damage;
+    // STATUS_BITs that goes with the damage
+    unsigned int inflicts;
+    // hard cap. at the cap, cosmetic ones just don't spawn, others push out the oldest
+    int max_count;
+    bool cosmetic;
     PDrawFunc draw;
+    PUpdateFunc update;
 } ParticleAttrs;
 
 typedef struct {
-    Timer basic_enemy_spawn,
-        large_enemy_spawn,
-        player_invinc,
-        player_fire_bullet,
-        player_fire_shell;
+    Timer player_invinc,
+        player_melee;
+    /* one per WeaponDef, see UpdateWeapons */
+    Timer weapons[MAX_WEAPONS];
 } GameTimers;
 
+/* what the player wants to do this tick, from the keyboard/mouse or the bot */
 typedef struct {
-    bool loaded;
-    const char *filepath;
-    Texture2D data;
-} GameTexture;
+    /* -1, 0 or 1 on each axis */
+    int move_x, move_y;
+    /* world coords, shells fire at this */
+    Vector2 aim;
+} PlayerInput;
 
-typedef struct {
+struct Game {
     struct {
         Vector2 window_init_dim;
         bool window_initialized;
@@ -137,155 +242,289 @@ typedef struct {
         /* +2 for player */
         EntityAttrs entitydata[E_COUNT+2];
         ParticleAttrs particledata[P_COUNT];
-        EntityType enemy_types[2];
-        EntityType projectile_types[2];
+        EntityType enemy_types[3];
+        EntityType projectile_types[4];
+        DirectorConfig director;
+        QualityConfig quality;
+        MeleeConfig melee;
+        /* what ranged enemies shoot */
+        HostileConfig hostile;
+        GemConfig gems;
+        DamageNumberConfig numbers;
+        MinimapConfig minimap;
+        StatusConfig status[STATUS_COUNT];
+        /* what the player shoots, see weapons.h */
+        WeaponDef weapons[MAX_WEAPONS];
+        /* bytes for every entity and particle vec together, max_counts
+           get scaled down to fit */
+        size_t storage_budget;
+        /* AreaDamages alive at once, at the cap the oldest goes */
+        int max_areas;
+        /* T cycles through these, [0] is the default */
+        const char *backgrounds[6];
+        /* decoded bytes of textures kept on the GPU */
+        size_t texture_budget;
+        /* px, for enemy_grid */
+        float grid_cell_size;
     } config;
     struct {
-        GameTexture background;
+        /* NULL when headless */
+        TextureCache *cache;
+        CachedTexture *background;
+        /* swapped in for background once it's loaded */
+        CachedTexture *next_background;
+        int background_index;
     } textures;
     GameTimers timers;
     struct {
         Button start_btn, restart_btn;
         float gametime;
+        /* the world as it was when the game was paused, drawn once */
+        RenderTexture2D paused_frame;
+        bool paused_frame_loaded, paused_frame_valid;
+        /* ClockSeconds when InitGame started, for startup timings */
+        double start_time;
+        /* idle mode, see IdleShouldRedraw */
+        bool idle_dirty, idle_hover, idle_focused;
     } ui;
     GameState state;
     Camera2D camera;
     Entity player;
+    PlayerInput input;
+    /* next id AddEntity hands out, 0 is never used */
+    unsigned int next_id;
+    /* state for rand_r, kept here so snapshots can restore it */
+    unsigned int rng;
+
+    /* decides what spawns and how tough it is */
+    SpawnDirector director;
+    /* decides how good it looks */
+    QualityGovernor quality;
+    /* the current swing, if there is one */
+    MeleeState melee;
+    /* indexed like config.weapons */
+    WeaponState weapons[MAX_WEAPONS];
+    /* everything the enemies have fired */
+    HostileShots hostile;
+    /* what they leave behind */
+    GemField gems;
+    /* from gems picked up */
+    int xp;
+    /* floating over what's been hit */
+    DamageNumbers numbers;
+    /* bottom right */
+    Minimap minimap;
+    /* who's burning, frozen, poisoned */
+    StatusList status[STATUS_COUNT];
+
+    /* every enemy, rebuilt each tick once they've moved, see BuildEnemyGrid */
+    SpatialGrid enemy_grid;
 
     /* indexed by type */
     EntityVec entities[E_COUNT];
     /* now indexed as well */
     ParticleVec particles[P_COUNT];
-} Game;
+    /* AddEntities' scratch, reserved for the biggest max_count */
+    vec_t(EvictCandidate) evicting;
+    /* UpdateWeapons' scratch, every volley a weapon owes this tick */
+    EntityVec volleys;
+
+    /* what explosions (or anything else with damage) are doing to enemies */
+    AreaDamageVec areas;
+    /* who areas.data[i] has hit is area_hits[i], max_areas of them. they
+       keep their storage when an area goes, so the next one reuses it */
+    HitSet *area_hits;
+
+    /* debug */
+    bool show_hitboxes;
+    /* quality level and frame headroom in the corner, F3 */
+    bool show_metrics;
+    /* no window, no textures, no input - for batch runs */
+    bool headless;
+    /* the bot drives input instead of the keyboard and mouse */
+    bool autopilot;
+    Bot bot;
+    /* NULL unless a state stream is being written */
+    Recorder *recorder;
+    /* last few seconds of history, NULL when headless */
+    FlightRecorder *flight;
+    /* loads textures in the background, NULL when headless */
+    AssetLoader *loader;
+};
+
+/* default config and starting state, copied into every context */
+extern const Game game_defaults;
 
 /* game methods */
 
-void InitGame(void);
-void RunGame(void);
-void ReinitGame(void);
-void DestroyGame(void);
+void InitGameContext(Game*, unsigned int seed);
+void InitGameHeadless(Game*, unsigned int seed);
+void DestroyGameContext(Game*);
+
+void InitGame(Game*);
+void RunGame(Game*);
+void ReinitGame(Game*);
+void DestroyGame(Game*);
+
+void SetState(Game*, GameState);
+bool GameplayAssetsReady(Game*);
+
+bool IdleState(GameState);
+bool IdleShouldRedraw(Game*);
 
-void SetState(GameState);
+void GameTick(Game*);
 
-void HandleInput(void);
-void CheckTimers(void);
-void UpdateCam(void);
+void HandleInput(Game*);
+void MovePlayer(Game*, int move_x, int move_y);
+void CheckTimers(Game*);
+void UpdateCam(Game*);
 
-void UpdateGameTime(void);
+void UpdateGameTime(Game*);
 
-void InitTexture(GameTexture*);
-void DeinitTexture(GameTexture*);
+void CycleBackground(Game*);
+void SwapBackground(Game*);
 
-void InitGameTimers(void);
+void InitGameTimers(Game*);
 
 void GameSleep(float secs);
 
 /* gamestate draw functions */
 
-void DrawTitle(void);
-void DrawGameplay(void);
-void DrawPaused(void);
-void DrawGameover(void);
+void DrawTitle(Game*);
+void DrawGameplay(Game*);
+void DrawPaused(Game*);
+void DrawGameover(Game*);
 
 /* draw functions */
 
-void TileBackground(void);
+void DrawWorld(Game*, bool sprite_flickering);
+void CapturePausedFrame(Game*);
+void TileBackground(Game*);
 
 void DrawEntityHitbox(Entity*);
 
-void DrawPlayer(bool sprite_flickering);
-void DamagePlayer(int amount);
-void HealPlayer(int amount);
+void DrawPlayer(Game*, bool sprite_flickering);
+void DamagePlayer(Game*, int amount);
+void HealPlayer(Game*, int amount);
 
 /* generics */
 
-void DrawEntity(Entity*);
-void UpdateEntity(Entity*);
+void DrawEntity(Game*, Entity*);
+void UpdateEntity(Game*, Entity*);
 
-void DrawBasicEnemy(Entity*);
-void UpdateBasicEnemy(Entity*);
+void DrawBasicEnemy(Game*, Entity*);
+void UpdateBasicEnemy(Game*, Entity*);
 
-void DrawLargeEnemy(Entity*);
-void UpdateLargeEnemy(Entity*);
+void DrawLargeEnemy(Game*, Entity*);
+void UpdateLargeEnemy(Game*, Entity*);
 
-void DrawProjectile(Entity*);
-void UpdateProjectile(Entity*);
+void DrawRangedEnemy(Game*, Entity*);
+void UpdateRangedEnemy(Game*, Entity*);
 
-void DrawBullet(Entity*);
-void DrawShell(Entity*);
+void DrawProjectile(Game*, Entity*);
+void UpdateProjectile(Game*, Entity*);
+
+void DrawBullet(Game*, Entity*);
+void DrawShell(Game*, Entity*);
+void DrawSpike(Game*, Entity*);
+void DrawArc(Game*, Entity*);
 
 /* game ui elements */
 
-void DrawGameUI(void);
+void DrawGameUI(Game*);
 
-void DisplayPlayerHP(void);
-void DisplayGameTime(void);
+void DisplayPlayerHP(Game*);
+void DisplayGameTime(Game*);
+void DisplayXP(Game*);
+void DisplayMetrics(Game*);
 
 /* entity methods */
 
 Rectangle EntityHitbox(Entity);
 
-void DrawEntities(bool update);
-void DrawParticles(bool update);
-
-Entity RandSpawnEnemy(EntityType);
-Entity PlayerFireBullet(void);
-Entity PlayerFireShell(void);
-
-void MoveEntityToPlayer(Entity*);
+void UpdateEntities(Game*);
+void BuildEnemyGrid(Game*);
+void MergeEnemies(Game*);
+void DamageEnemy(Game*, Entity*, int amount);
+void KillEnemy(Game*, Entity*);
+void RemoveEntity(Game*, EntityType, int index);
+void RemoveDeadEnemies(Game*);
+void IntegrateProjectiles(EntityVec*);
+bool SweepProjectile(Game*, Entity *proj, Vector2 *motion, Entity **hit);
+void ProjectileHit(Game*, Entity *proj, Entity *target, Vector2 *motion);
+bool HitListHas(HitList*, unsigned int id);
+void DrawEntities(Game*);
+void UpdateParticles(Game*);
+void DrawParticles(Game*);
+
+void ReserveStorage(Game*);
+void AddEntity(Game*, Entity);
+void AddEntities(Game*, Entity*, int count);
+Entity RandSpawnEnemy(Game*, EntityType);
+void AbsorbEnemy(Game*, Entity *e, Entity *other);
+Entity NewProjectile(Game*, EntityType, float angle);
+
+void MoveEntityToPlayer(Game*, Entity*);
 
 /* particle methods */
 
 Rectangle ParticleHitbox(Particle);
 void DrawParticleHitbox(Particle*);
 
-void SpawnParticle(ParticleType, float x, float y);
-Particle NewParticle(ParticleType, float x, float y);
+void SpawnParticle(Game*, ParticleType, float x, float y);
+Particle NewParticle(Game*, ParticleType, float x, float y);
 bool ParticleDone(Particle);
 
 /* generics */
 
-void DrawParticle(Particle*, bool advance_frame);
+void DrawParticle(Game*, Particle*);
+void UpdateParticle(Game*, Particle*);
+
+void SpawnPExplosion(Game*, float x, float y);
+void SpawnPEnemyFadeout(Game*, Entity*);
+
+void DrawPExplosion(Game*, Particle*);
+void UpdatePExplosion(Particle*);
+void DrawPEnemyFadeout(Game*, Particle*);
 
-void SpawnPExplosion(float x, float y);
-void SpawnPEnemyFadeout(Entity*);
+/* area damage */
 
-void DrawPExplosion(Particle*, bool advance_frame);
-void DrawPEnemyFadeout(Particle*, bool advance_frame);
+bool InsertSortedId(unsigned int *ids, int *count, int max, unsigned int id);
+bool HitSetAdd(HitSet*, unsigned int id);
+void AddAreaDamage(Game*, ParticleType, float x, float y);
+void RemoveAreaDamage(Game*, int index);
+void UpdateAreaDamage(Game*);
 
 
 /* general utils */
 
-Vector2 screensize(void);
-Vector2 screen_offset(void);
+Vector2 screensize(Game*);
+Vector2 screen_offset(Game*);
+Rectangle screen_view(Game*);
 
-int randrange(int min, int max);
-float randfloat(float min, float max);
-float randchoice(size_t count, float *probs, ...);
+int randrange(Game*, int min, int max);
+float randfloat(Game*, float min, float max);
+float randchoice(Game*, size_t count, float *probs, ...);
 
 float distance(Vector2, Vector2);
 
 bool is_collision(Entity, Entity);
 bool is_p_collision(Particle, Entity);
-bool entity_offscreen(Entity);
+bool entity_offscreen(Game*, Entity);
 
 float entity_distance(Entity, Entity);
 float entity_angle(Entity, Entity);
 float vec_angle(Vector2, Vector2);
-Entity *player_closest_entity(EntityType);
-Entity *player_closest_enemy(void);
+Entity *player_closest_entity(Game*, EntityType);
+Entity *player_closest_enemy(Game*);
+Vector2 PlayerAim(Game*);
 
-/* callbacks */
+/* callbacks - ctx is always the Game* */
 
-void StartBtnCallback(void);
-void RestartBtnCallback(void);
+void StartBtnCallback(void *ctx);
+void RestartBtnCallback(void *ctx);
 
-void BasicEnemySpawnTimerCallback(void);
-void LargeEnemySpawnTimerCallback(void);
-void PlayerInvincTimerCallback(void);
-void PlayerBulletTimerCallback(void);
-void PlayerShellTimerCallback(void);
+void PlayerInvincTimerCallback(void *ctx, int count, float late);
 
-void DoNothingCallback(void);
 
 #endif /* _GAME_H_ */
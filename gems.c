@@ -0,0 +1,224 @@
+#include "gems.h"
+#include "game.h"
+
+void InitGems(Game *game) {
+    GemField *f = &game->gems;
+    int max = game->config.gems.max_gems;
+
+    *f = (GemField){0};
+    vec_init(&f->gems);
+    vec_init(&f->pulled);
+    vec_reserve(&f->gems, max);
+    vec_reserve(&f->pulled, GEM_MAX_PULLED);
+    InitSpatialGrid(&f->grid, game->config.gems.cell_size, max);
+    ClearGems(game);
+}
+
+void FreeGems(Game *game) {
+    vec_deinit(&game->gems.gems);
+    vec_deinit(&game->gems.pulled);
+    FreeSpatialGrid(&game->gems.grid);
+}
+
+/* half the size of the area the grid covers, twice the spawn ring */
+static Vector2 grid_reach(Game *game) {
+    return (Vector2){
+        2 * game->config.screen_margin[1] * screensize(game).x/2,
+        2 * game->config.screen_margin[1] * screensize(game).y/2,
+    };
+}
+
+static Rectangle gem_box(Gem g) {
+    return (Rectangle){ g.x - 1, g.y - 1, 2, 2 };
+}
+
+/* takes the zeroed ones out */
+static void pack_gems(GemField *f) {
+    int n = 0;
+
+    for (int i = 0; i < f->gems.length; i++) {
+        if (f->gems.data[i].value > 0) {
+            f->gems.data[n++] = f->gems.data[i];
+        }
+    }
+    f->gems.length = n;
+}
+
+static void file_gems(Game *game) {
+    GemField *f = &game->gems;
+    Vector2 reach = grid_reach(game);
+
+    f->centre = (Vector2){ game->player.x, game->player.y };
+    BeginSpatialGrid(&f->grid, (Rectangle){ f->centre.x - reach.x, f->centre.y - reach.y, 2 * reach.x, 2 * reach.y });
+    for (int i = 0; i < f->gems.length; i++) {
+        SpatialAdd(&f->grid, (SpatialRef){ 0, i }, gem_box(f->gems.data[i]));
+    }
+    EndSpatialGrid(&f->grid);
+    f->filed = f->gems.length;
+    f->taken = 0;
+}
+
+void ClearGems(Game *game) {
+    vec_clear(&game->gems.gems);
+    vec_clear(&game->gems.pulled);
+    // an empty grid, so there's always one to ask
+    file_gems(game);
+}
+
+/* everything in a cell goes into the first gem in it, which moves to the
+   middle of them (by value). false if nothing was merged.
+
+   the edge cells also hold everything past the edge, which is left behind
+   wherever the player's been. all of that goes into one gem where the
+   first of it was, so it can't fill the field up */
+static bool merge_gems(GemField *f) {
+    SpatialGrid *grid = &f->grid;
+    int cells = grid->cols * grid->rows;
+    bool merged = false;
+    Gem *into, *far = NULL, *g;
+
+    for (int c = 0; c < cells; c++) {
+        into = NULL;
+        for (int i = grid->start.data[c]; i < grid->start.data[c + 1]; i++) {
+            g = &f->gems.data[grid->items.data[i].ref.index];
+            if (!CheckCollisionPointRec((Vector2){ g->x, g->y }, grid->bounds)) {
+                if (far == NULL) {
+                    far = g;
+                } else {
+                    far->value += g->value;
+                    g->value = 0;
+                    merged = true;
+                }
+                continue;
+            }
+            if (into == NULL) {
+                into = g;
+                continue;
+            }
+            into->x += (g->x - into->x) * g->value / (float) (into->value + g->value);
+            into->y += (g->y - into->y) * g->value / (float) (into->value + g->value);
+            into->value += g->value;
+            g->value = 0;
+            merged = true;
+        }
+    }
+    return merged;
+}
+
+void RefileGems(Game *game) {
+    GemField *f = &game->gems;
+
+    pack_gems(f);
+    file_gems(game);
+    if (f->gems.length > game->config.gems.merge_at && merge_gems(f)) {
+        pack_gems(f);
+        file_gems(game);
+    }
+}
+
+void DropGem(Game *game, float x, float y, int value) {
+    GemField *f = &game->gems;
+
+    if (f->gems.length >= game->config.gems.max_gems) {
+        RefileGems(game);
+    }
+    // nothing would merge, so it's lost
+    if (f->gems.length >= game->config.gems.max_gems) {
+        return;
+    }
+    vec_push(&f->gems, ((Gem){ x, y, value }));
+}
+
+/* false if too many are on their way already, it'll get another go next tick */
+static bool pull_gem(GemField *f, Gem g) {
+    if (f->pulled.length >= f->pulled.capacity) {
+        return false;
+    }
+    vec_push(&f->pulled, g);
+    return true;
+}
+
+void UpdateGems(Game *game) {
+    GemField *f = &game->gems;
+    GemConfig *c = &game->config.gems;
+    Vector2 player = { game->player.x, game->player.y };
+    Vector2 reach = grid_reach(game);
+    SpatialRef *refs;
+    Gem *g;
+    float dist;
+    int count;
+
+    if (f->gems.length - f->filed > GEM_MAX_UNFILED
+        || f->taken > f->filed / 2
+        || fabsf(player.x - f->centre.x) > reach.x / 2
+        || fabsf(player.y - f->centre.y) > reach.y / 2) {
+        RefileGems(game);
+    }
+
+    /* the magnet */
+    refs = SpatialQueryCircle(&f->grid, player, c->magnet_radius, &count);
+    for (int k = 0; k < count; k++) {
+        g = &f->gems.data[refs[k].index];
+        if (g->value > 0 && pull_gem(f, *g)) {
+            g->value = 0;
+            f->taken++;
+        }
+    }
+    for (int i = f->filed; i < f->gems.length; i++) {
+        g = &f->gems.data[i];
+        if (distance(player, (Vector2){ g->x, g->y }) <= c->magnet_radius && pull_gem(f, *g)) {
+            // whatever's swapped in from the end isn't filed either
+            vec_remove(&f->gems, i);
+            i--;
+        }
+    }
+
+    /* the ones on their way */
+    for (int i = 0; i < f->pulled.length; i++) {
+        g = &f->pulled.data[i];
+        dist = distance(player, (Vector2){ g->x, g->y });
+        if (dist <= c->pickup_radius + c->pull_speed) {
+            game->xp += g->value;
+            vec_remove(&f->pulled, i);
+            i--;
+            continue;
+        }
+        g->x += (player.x - g->x) / dist * c->pull_speed;
+        g->y += (player.y - g->y) / dist * c->pull_speed;
+    }
+}
+
+/* bigger and a different colour every 5x in value */
+static void draw_gem(Gem g) {
+    static const Color colours[] = { SKYBLUE, GREEN, GOLD, ORANGE, RED };
+    int tier = 0;
+
+    for (int v = g.value; v >= 5 && tier < len(colours) - 1; v /= 5) {
+        tier++;
+    }
+    DrawPoly((Vector2){ g.x, g.y }, 4, 3 + tier, 45, colours[tier]);
+}
+
+void DrawGems(Game *game) {
+    GemField *f = &game->gems;
+    Rectangle view = screen_view(game);
+    SpatialRef *refs;
+    Gem *g;
+    int count;
+
+    refs = SpatialQuery(&f->grid, view, &count);
+    for (int k = 0; k < count; k++) {
+        g = &f->gems.data[refs[k].index];
+        if (g->value > 0) {
+            draw_gem(*g);
+        }
+    }
+    for (int i = f->filed; i < f->gems.length; i++) {
+        if (CheckCollisionPointRec((Vector2){ f->gems.data[i].x, f->gems.data[i].y }, view)) {
+            draw_gem(f->gems.data[i]);
+        }
+    }
+    for (int i = 0; i < f->pulled.length; i++) {
+        draw_gem(f->pulled.data[i]);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef _GEMS_H_
+#define _GEMS_H_
+
+#include "raylib.h"
+#include "vec.h"
+
+#include "spatial.h"
+
+/*
+    experience gems, dropped where enemies die and picked up by walking
+    over them. inside magnet_radius they come to the player on their own.
+
+    gems don't move until they're pulled, so unlike enemy_grid the gem
+    grid isn't rebuilt every tick. gems[0 .. filed) are in it, anything
+    dropped since sits after that and is looked at one by one until there
+    are enough of them to be worth filing. a filed gem that gets pulled
+    is only zeroed (value 0) so the grid's indices stay valid, refiling
+    packs them out. it refiles when:
+
+    - more than GEM_MAX_UNFILED have been dropped since
+    - the player has walked far enough from where it was filed around
+      that the magnet would be looking at the grid's edge cells
+    - too many filed gems are zeroed
+    - the field is full
+
+    once there are more than merge_at gems, refiling also merges the
+    ones in each grid cell into one worth all of them, and everything
+    past the grid's edge into one big one.
+*/
+
+#define GEM_MAX_UNFILED 256
+/* the most that can be on their way to the player at once */
+#define GEM_MAX_PULLED 4096
+
+typedef struct Game Game;
+
+typedef struct {
+    float x, y;
+    /* 0 = already picked up or merged into another */
+    int value;
+} Gem;
+
+typedef vec_t(Gem) GemVec;
+
+typedef struct {
+    float magnet_radius;
+    /* how close they have to get to count as picked up */
+    float pickup_radius;
+    /* px per tick, faster than the player can run */
+    float pull_speed;
+    /* gems in the same grid cell merge past this many */
+    int merge_at;
+    /* hard cap, see ReserveStorage */
+    int max_gems;
+    /* px, for the gem grid */
+    float cell_size;
+} GemConfig;
+
+typedef struct {
+    /* lying around, see above */
+    GemVec gems;
+    int filed;
+    /* zeroed ones among the filed */
+    int taken;
+    /* where the grid was filed around */
+    Vector2 centre;
+    SpatialGrid grid;
+    /* on their way to the player */
+    GemVec pulled;
+} GemField;
+
+void InitGems(Game*);
+void FreeGems(Game*);
+void ClearGems(Game*);
+/* files everything again, straight away */
+void RefileGems(Game*);
+
+void DropGem(Game*, float x, float y, int value);
+/* after the player has moved */
+void UpdateGems(Game*);
+void DrawGems(Game*);
+
+#endif /* _GEMS_H_ */
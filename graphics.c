@@ -1,9 +1,5 @@
 #include "graphics.h"
 
-/* gets top left corner position */
-ScreenOffsetFunc GraphicsGetScreenOffset;
-ScreenSizeFunc GraphicsGetScreenSize;
-
 Button NewButton(float x, float y, float w, float h, const char *label, BtnCallback callback) {
     return (Button) {
         .x = x,
@@ -15,18 +11,15 @@ Button NewButton(float x, float y, float w, float h, const char *label, BtnCallb
     };
 }
 
-void DrawButton(Button b) {
-
-    Vector2 offset = GraphicsGetScreenOffset();
-    Vector2 size = GraphicsGetScreenSize();
+void DrawButton(Rectangle view, Button b, void *ctx) {
 
-    float x = offset.x + ((b.x / 100.0) * size.x);
-    float y = offset.y + ((b.y / 100.0) * size.y);
-    float w = b.w / 100.0 * size.x;
-    float h = b.h / 100.0 * size.y;
+    float x = view.x + ((b.x / 100.0) * view.width);
+    float y = view.y + ((b.y / 100.0) * view.height);
+    float w = b.w / 100.0 * view.width;
+    float h = b.h / 100.0 * view.height;
     
     Color fill = (Color) {220, 220, 220, 255};
-    if (MouseInside(b)) {
+    if (MouseInside(view, b)) {
         if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
             fill = (Color) {200, 200, 200, 255};
         } else {
@@ -36,47 +29,41 @@ void DrawButton(Button b) {
     
     DrawRectangleRoundedLines((Rectangle){ x, y, w, h }, 0.2f, 10, 2.0f, DARKGRAY);
     DrawRectangleRounded((Rectangle) { x, y, w, h }, 0.2f, 10, fill);
-    DrawTextUI(b.label, b.x+b.w/2, b.y+b.h/2, h/2, BLACK);
+    DrawTextUI(view, b.label, b.x+b.w/2, b.y+b.h/2, h/2, BLACK);
     
-    if (MouseInside(b) && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-        b.on_click();
+    if (MouseInside(view, b) && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        b.on_click(ctx);
     }
 }
 
 /* text methods */
 
-float GetScaledFontSize(float scale) {
+float GetScaledFontSize(Rectangle view, float scale) {
     return (
-        sqrtf(powf(GraphicsGetScreenSize().x, 2.0f) + powf(GraphicsGetScreenSize().y, 2.0f)) / 
+        sqrtf(powf(view.width, 2.0f) + powf(view.height, 2.0f)) / 
         sqrtf(pow(800, 2) + pow(450, 2))
     ) * scale;
 }
 
 /* centered */
-void DrawTextUI(const char *text, float x_percent, float y_percent, float font_scale, Color color) {
-    
-    Vector2 offset = GraphicsGetScreenOffset();
-    Vector2 size = GraphicsGetScreenSize();
+void DrawTextUI(Rectangle view, const char *text, float x_percent, float y_percent, float font_scale, Color color) {
 
-    float fontSize = GetScaledFontSize(font_scale);
+    float fontSize = GetScaledFontSize(view, font_scale);
 
-    float x = offset.x + ((x_percent / 100.0) * size.x);
-    float y = offset.y + ((y_percent / 100.0) * size.y);
+    float x = view.x + ((x_percent / 100.0) * view.width);
+    float y = view.y + ((y_percent / 100.0) * view.height);
     float w = MeasureText(text, fontSize);
     float h = fontSize; // right?
 
     DrawTextEx(GetFontDefault(), text, (Vector2){x-w/2, y-h/2}, fontSize, 1.0f, color);
 }
 
-bool MouseInside(Button b) {
-
-    Vector2 offset = GraphicsGetScreenOffset();
-    Vector2 size = GraphicsGetScreenSize();
+bool MouseInside(Rectangle view, Button b) {
 
-    float x = offset.x + (b.x / 100 * size.x);
-    float y = offset.y + (b.y / 100 * size.y);
-    float w = b.w / 100 * size.x;
-    float h = b.h / 100 * size.y;
+    float x = view.x + (b.x / 100 * view.width);
+    float y = view.y + (b.y / 100 * view.height);
+    float w = b.w / 100 * view.width;
+    float h = b.h / 100 * view.height;
 
     int mx = GetMouseX();
     int my = GetMouseY();
@@ -8,10 +8,8 @@
 
 #include "raylib.h"
 
-typedef Vector2 (*ScreenOffsetFunc)(void);
-typedef Vector2 (*ScreenSizeFunc)(void);
-
-typedef void (*BtnCallback)(void);
+/* ctx is whatever was passed to DrawButton */
+typedef void (*BtnCallback)(void *ctx);
 
 typedef struct {
 
@@ -21,15 +19,20 @@ typedef struct {
     BtnCallback on_click;
 } Button;
 
+/*
+    every ui method takes the view it draws into: x, y is the top left
+    corner of the screen in world coords and width, height is its size
+*/
+
 /* text methods */
 
-float GetScaledFontSize(float scale);
-void DrawTextUI(const char *text, float x_percent, float y_percent, float font_scale, Color color);
+float GetScaledFontSize(Rectangle view, float scale);
+void DrawTextUI(Rectangle view, const char *text, float x_percent, float y_percent, float font_scale, Color color);
 
 /* button methods */
 
 Button NewButton(float x, float y, float w, float h, const char *label, BtnCallback callback);
-void DrawButton(Button b);
-bool MouseInside(Button b);
+void DrawButton(Rectangle view, Button b, void *ctx);
+bool MouseInside(Rectangle view, Button b);
 
 #endif
@@ -0,0 +1,107 @@
+#include "hostile.h"
+#include "game.h"
+#include "simd.h"
+
+_Static_assert(sizeof(v4f) == HOSTILE_BATCH * sizeof(float), "v4f has to be HOSTILE_BATCH wide");
+
+void InitHostile(Game *game) {
+    HostileShots *s = &game->hostile;
+    int max = game->config.hostile.max_shots;
+
+    *s = (HostileShots){ .capacity = (max + HOSTILE_BATCH - 1) / HOSTILE_BATCH * HOSTILE_BATCH };
+    // one block for all of them, x then y then vx then vy, then where the gone ones are
+    s->x = MemAlloc(s->capacity * HOSTILE_SHOT_SIZE);
+    s->y = s->x + s->capacity;
+    s->vx = s->y + s->capacity;
+    s->vy = s->vx + s->capacity;
+    s->gone = (int *) (s->vy + s->capacity);
+}
+
+void FreeHostile(Game *game) {
+    MemFree(game->hostile.x);
+    game->hostile = (HostileShots){0};
+}
+
+void FireHostileShot(Game *game, float x, float y, float angle) {
+    HostileShots *s = &game->hostile;
+    float speed = game->config.hostile.speed;
+
+    if (s->count >= game->config.hostile.max_shots) {
+        return;
+    }
+    s->x[s->count] = x;
+    s->y[s->count] = y;
+    s->vx[s->count] = speed * cosf(angle);
+    s->vy[s->count] = speed * sinf(angle);
+    s->count++;
+}
+
+void UpdateHostileShots(Game *game) {
+    HostileShots *s = &game->hostile;
+    HostileConfig *c = &game->config.hostile;
+    Rectangle hurt = EntityHitbox(game->player);
+    float w = game->config.screen_margin[0] * screensize(game).x/2;
+    float h = game->config.screen_margin[0] * screensize(game).y/2;
+    v4f x, y;
+    v4i near, out, flag;
+    int removed = 0, j, last;
+
+    /* the hurtbox grown by the radius, nothing outside it can be touching */
+    v4f near_x0 = splat4(hurt.x - c->size), near_x1 = splat4(hurt.x + hurt.width + c->size);
+    v4f near_y0 = splat4(hurt.y - c->size), near_y1 = splat4(hurt.y + hurt.height + c->size);
+    /* same as entity_offscreen */
+    v4f view_x0 = splat4(game->player.x - w), view_x1 = splat4(game->player.x + w);
+    v4f view_y0 = splat4(game->player.y - h), view_y1 = splat4(game->player.y + h);
+    v4i lane = { 0, 1, 2, 3 };
+
+    for (int i = 0; i < s->count; i += HOSTILE_BATCH) {
+        x = load4(s->x + i) + load4(s->vx + i);
+        y = load4(s->y + i) + load4(s->vy + i);
+        // the last batch writes past count too, those lanes are never read
+        store4(s->x + i, x);
+        store4(s->y + i, y);
+
+        near = (x >= near_x0) & (x <= near_x1) & (y >= near_y0) & (y <= near_y1);
+        out = (x < view_x0) | (x > view_x1) | (y < view_y0) | (y > view_y1);
+        flag = (near | out) & (lane < splat4i(s->count - i));
+
+        /* almost every batch stops here */
+        if (!(flag[0] | flag[1] | flag[2] | flag[3])) {
+            continue;
+        }
+        for (int k = 0; k < HOSTILE_BATCH; k++) {
+            if (!flag[k]) {
+                continue;
+            }
+            if (out[k]) {
+                s->gone[removed++] = i + k;
+            } else if (CheckCollisionCircleRec((Vector2){ x[k], y[k] }, c->size, hurt)) {
+                DamagePlayer(game, c->damage);
+                s->gone[removed++] = i + k;
+            }
+        }
+    }
+
+    /* gone is in order, so going backwards whatever comes in from the end
+       is never one that's still to go */
+    while (removed > 0) {
+        j = s->gone[--removed];
+        last = --s->count;
+        s->x[j] = s->x[last];
+        s->y[j] = s->y[last];
+        s->vx[j] = s->vx[last];
+        s->vy[j] = s->vy[last];
+    }
+}
+
+void DrawHostileShots(Game *game) {
+    HostileShots *s = &game->hostile;
+    Rectangle view = screen_view(game);
+    float r = game->config.hostile.size;
+
+    for (int i = 0; i < s->count; i++) {
+        if (CheckCollisionCircleRec((Vector2){ s->x[i], s->y[i] }, r, view)) {
+            DrawCircleQ(game, s->x[i], s->y[i], r, PURPLE);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef _HOSTILE_H_
+#define _HOSTILE_H_
+
+#include "raylib.h"
+
+/*
+    shots enemies fire at the player.
+
+    the player is the only thing they can hit, so they skip Entity and
+    the grid altogether: each field is its own array, and one pass moves
+    every shot and tests it against the player's hurtbox, 4 at a time.
+    anything that passes the box test (the hurtbox grown by the shot's
+    radius) gets the exact circle test, which is next to nothing since
+    it's only ever a handful.
+
+    there's no order to them, removing one moves the last into its place.
+*/
+
+/* shots handled by one step of the batched pass */
+#define HOSTILE_BATCH 4
+/* bytes each shot takes, for ReserveStorage */
+#define HOSTILE_SHOT_SIZE (4 * sizeof(float) + sizeof(int))
+
+typedef struct Game Game;
+
+typedef struct {
+    /* px per tick */
+    float speed;
+    /* radius */
+    float size;
+    int damage;
+    /* hard cap, at the cap new shots just don't get fired */
+    int max_shots;
+} HostileConfig;
+
+typedef struct {
+    int count;
+    /* max_shots rounded up to a whole batch, so the last one can read
+       past count without leaving the arrays */
+    int capacity;
+    float *x, *y;
+    float *vx, *vy;
+    /* what UpdateHostileShots is taking out, in order */
+    int *gone;
+} HostileShots;
+
+void InitHostile(Game*);
+void FreeHostile(Game*);
+
+void FireHostileShot(Game*, float x, float y, float angle);
+/* after the enemies have moved (and fired) */
+void UpdateHostileShots(Game*);
+void DrawHostileShots(Game*);
+
+#endif /* _HOSTILE_H_ */
@@ -1,7 +1,65 @@
 #include "game.h"
+#include "batch.h"
+#include "record.h"
+#include "snapshot.h"
 
-int main() {
+static Game game;
+
+int main(int argc, char **argv) {
+    BatchConfig batch = DEFAULT_BATCH_CONFIG;
+    const char *snapshot = NULL;
+    const char *recording = NULL;
+    bool autopilot = false;
+    bool profile_startup = false;
+
+    for (int i = 1; i < argc; i++) {
+        /* time every step up to the first frame */
+        if (strcmp(argv[i], "--profile-startup") == 0) {
+            profile_startup = true;
+        }
+        /* jump straight into a saved scenario */
+        else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshot = argv[++i];
+        }
+        /* headless matches, no window */
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch.matches = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            batch.max_ticks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            batch.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            batch.seed = strtoul(argv[++i], NULL, 10);
+        }
+        /* write a state stream, read it with build/streamdump */
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recording = argv[++i];
+        }
+        /* let the bot play */
+        else if (strcmp(argv[i], "--bot") == 0) {
+            autopilot = true;
+        }
+    }
+
+    if (batch.matches > 0) {
+        batch.autopilot = autopilot;
+        RunBatch(batch);
+        return 0;
+    }
+
+    /* not in batch, the workers would all mark the same profile */
+    if (profile_startup) {
+        EnableStartupProfile();
+    }
     SetTraceLogLevel(LOG_ERROR);
-    InitGame();
-    RunGame();
+    InitGame(&game);
+    game.autopilot = autopilot;
+    if (snapshot != NULL) {
+        LoadSnapshot(&game, snapshot);
+    }
+    if (recording != NULL) {
+        game.recorder = StartRecording(recording);
+    }
+    RunGame(&game);
+    StopRecording(game.recorder);
 }
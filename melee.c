@@ -0,0 +1,71 @@
+#include "melee.h"
+#include "game.h"
+
+void InitMelee(Game *game) {
+    int capacity = 0;
+
+    for (int i = 0; i < len(game->config.enemy_types); i++) {
+        capacity += game->config.entitydata[game->config.enemy_types[i]].max_count;
+    }
+    game->melee = (MeleeState){0};
+    vec_init(&game->melee.hits);
+    vec_reserve(&game->melee.hits, capacity);
+}
+
+void FreeMelee(Game *game) {
+    vec_deinit(&game->melee.hits);
+}
+
+void StartSwing(Game *game, float angle) {
+    game->melee.angle = angle;
+    game->melee.ticks_left = game->config.melee.active_ticks;
+    vec_clear(&game->melee.hits);
+}
+
+void UpdateMelee(Game *game) {
+    MeleeState *m = &game->melee;
+    MeleeConfig *c = &game->config.melee;
+    SpatialRef *refs;
+    Entity *target;
+    int count;
+
+    if (m->ticks_left <= 0) {
+        return;
+    }
+    m->ticks_left--;
+
+    refs = SpatialQuerySector(&game->enemy_grid, (Vector2){ game->player.x, game->player.y },
+        c->radius, m->angle, c->arc * DEG2RAD / 2, &count);
+    for (int k = 0; k < count; k++) {
+        target = &game->entities[refs[k].type].data[refs[k].index];
+        // dead already, or this swing got it on an earlier tick
+        if (target->hp <= 0 || !InsertSortedId(m->hits.data, &m->hits.length, m->hits.capacity, target->id)) {
+            continue;
+        }
+        DamageEnemy(game, target, c->damage);
+    }
+}
+
+void DrawMelee(Game *game) {
+    MeleeConfig *c = &game->config.melee;
+    float angle = game->melee.angle * RAD2DEG;
+
+    if (game->melee.ticks_left <= 0) {
+        return;
+    }
+    DrawCircleSector(
+        (Vector2){ game->player.x, game->player.y }, c->radius,
+        angle - c->arc / 2, angle + c->arc / 2,
+        QualitySetting(game)->circle_segments,
+        Fade(LIGHTGRAY, (float) game->melee.ticks_left / c->active_ticks)
+    );
+}
+
+/* swings at the mouse cursor (or wherever the bot aims), a late swing
+   still goes out, there's only ever one at a time */
+void PlayerMeleeTimerCallback(void *ctx, int count, float late) {
+    Game *game = ctx;
+    (void) count;
+    (void) late;
+    StartSwing(game, vec_angle((Vector2){ game->player.x, game->player.y }, PlayerAim(game)));
+}
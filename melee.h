@@ -0,0 +1,48 @@
+#ifndef _MELEE_H_
+#define _MELEE_H_
+
+#include "raylib.h"
+#include "vec.h"
+
+/*
+    the melee arc. every interval the player swings towards where they're
+    aiming, and for active_ticks everything inside the slice of the circle
+    (radius, arc wide) takes damage, once per swing.
+
+    the slice is asked of enemy_grid (SpatialQuerySector), so a swing only
+    looks at the cells it covers, not at every enemy around the player.
+*/
+
+typedef struct Game Game;
+
+typedef struct {
+    /* seconds between swings */
+    float interval;
+    float radius;
+    /* how wide the whole arc is, degrees */
+    float arc;
+    int damage;
+    /* ticks a swing hurts for */
+    int active_ticks;
+} MeleeConfig;
+
+typedef struct {
+    /* radians, where the current swing points */
+    float angle;
+    /* 0 between swings */
+    int ticks_left;
+    /* ids hit by this swing, sorted, reserved for every enemy there can be */
+    vec_t(unsigned int) hits;
+} MeleeState;
+
+void InitMelee(Game*);
+void FreeMelee(Game*);
+
+void StartSwing(Game*, float angle);
+/* after enemy_grid is built, before dead enemies are removed */
+void UpdateMelee(Game*);
+void DrawMelee(Game*);
+
+void PlayerMeleeTimerCallback(void *ctx, int count, float late);
+
+#endif /* _MELEE_H_ */
@@ -0,0 +1,141 @@
+#include "minimap.h"
+#include "flight.h"
+#include "game.h"
+#include "simd.h"
+
+/* nothing is see-through black, then yellow to red on a log scale */
+static void build_ramp(Color *ramp) {
+    float t;
+
+    ramp[0] = BLANK;
+    for (int i = 1; i < MINIMAP_RAMP; i++) {
+        t = log2f(i) / log2f(MINIMAP_RAMP - 1);
+        ramp[i] = (Color){ 255, 230 * (1 - t), 40 * (1 - t), 160 + 95 * t };
+    }
+}
+
+static void load_minimap(Game *game) {
+    Minimap *m = &game->minimap;
+    int size = game->config.minimap.size;
+    Image blank = GenImageColor(size, size, BLANK);
+
+    m->density = MemAlloc(size * size * sizeof(uint16_t));
+    m->pixels = MemAlloc(size * size * sizeof(Color));
+    build_ramp(m->ramp);
+    m->texture = LoadTextureFromImage(blank);
+    UnloadImage(blank);
+    // due straight away
+    m->last_update = -game->config.minimap.interval;
+    m->loaded = true;
+}
+
+void UnloadMinimap(Game *game) {
+    Minimap *m = &game->minimap;
+
+    if (!m->loaded) {
+        return;
+    }
+    UnloadTexture(m->texture);
+    MemFree(m->density);
+    MemFree(m->pixels);
+    m->density = NULL;
+    m->pixels = NULL;
+    m->loaded = false;
+}
+
+/* adds n entities to density. the pixel maths is done 4 at a time, only
+   the increments are one by one */
+static void splat_entities(Minimap *m, int size, Entity *e, int n) {
+    float scale = size / m->area.width;
+    v4f ox = splat4(m->area.x), oy = splat4(m->area.y);
+    v4f s = splat4(scale), edge = splat4(size);
+    v4f x, y;
+    v4i inside, pixel;
+    int i, px, py;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        x = ((v4f){ e[i].x, e[i+1].x, e[i+2].x, e[i+3].x } - ox) * s;
+        y = ((v4f){ e[i].y, e[i+1].y, e[i+2].y, e[i+3].y } - oy) * s;
+        inside = (x >= 0) & (x < edge) & (y >= 0) & (y < edge);
+        // the ones outside could be anything, zero them before they become ints
+        pixel = __builtin_convertvector(select4(inside, y), v4i) * size
+            + __builtin_convertvector(select4(inside, x), v4i);
+        for (int k = 0; k < 4; k++) {
+            if (inside[k]) {
+                m->density[pixel[k]]++;
+            }
+        }
+    }
+    for (; i < n; i++) {
+        px = (e[i].x - m->area.x) * scale;
+        py = (e[i].y - m->area.y) * scale;
+        if (e[i].x >= m->area.x && e[i].y >= m->area.y && px < size && py < size) {
+            m->density[py * size + px]++;
+        }
+    }
+}
+
+static void update_minimap(Game *game) {
+    Minimap *m = &game->minimap;
+    MinimapConfig *c = &game->config.minimap;
+    int pixels = c->size * c->size;
+    float half = c->range * game->config.screen_margin[1] * fmaxf(screensize(game).x, screensize(game).y) / 2;
+    EntityVec *ev;
+    double start = ClockSeconds();
+
+    m->area = (Rectangle){ game->player.x - half, game->player.y - half, 2 * half, 2 * half };
+    memset(m->density, 0, pixels * sizeof(uint16_t));
+    for (int i = 0; i < len(game->config.enemy_types); i++) {
+        ev = &game->entities[game->config.enemy_types[i]];
+        splat_entities(m, c->size, ev->data, ev->length);
+    }
+    for (int i = 0; i < pixels; i++) {
+        m->pixels[i] = m->ramp[m->density[i] < MINIMAP_RAMP ? m->density[i] : MINIMAP_RAMP - 1];
+    }
+    m->splat_secs = ClockSeconds() - start;
+
+    start = ClockSeconds();
+    UpdateTexture(m->texture, m->pixels);
+    m->upload_secs = ClockSeconds() - start;
+
+    m->last_update = game->ui.gametime;
+    if (game->flight != NULL) {
+        FlightRecordMinimapTime(game->flight, m->splat_secs + m->upload_secs);
+    }
+}
+
+/* a world rectangle as it is on the minimap at dst */
+static Rectangle on_minimap(Minimap *m, Rectangle dst, Rectangle world) {
+    float scale = dst.width / m->area.width;
+    return (Rectangle){
+        dst.x + (world.x - m->area.x) * scale,
+        dst.y + (world.y - m->area.y) * scale,
+        world.width * scale,
+        world.height * scale,
+    };
+}
+
+void DrawMinimap(Game *game) {
+    Minimap *m = &game->minimap;
+    MinimapConfig *c = &game->config.minimap;
+    Rectangle view = screen_view(game);
+    float side = view.height * c->screen_size / 100;
+    Rectangle dst = { view.x + view.width - side - 8, view.y + view.height - side - 8, side, side };
+    float ring_w = game->config.screen_margin[1] * view.width;
+    float ring_h = game->config.screen_margin[1] * view.height;
+
+    if (!m->loaded) {
+        load_minimap(game);
+    }
+    // restarted or loaded a snapshot, gametime went backwards
+    if (game->ui.gametime - m->last_update >= c->interval || game->ui.gametime < m->last_update) {
+        update_minimap(game);
+    }
+
+    DrawRectangleRec(dst, Fade(BLACK, 0.35f));
+    DrawTexturePro(m->texture, (Rectangle){ 0, 0, c->size, c->size }, dst, (Vector2){ 0, 0 }, 0, WHITE);
+    // the screen and the spawn ring, where the player is now
+    DrawRectangleLinesEx(on_minimap(m, dst, view), 1, WHITE);
+    DrawRectangleLinesEx(on_minimap(m, dst, (Rectangle){ game->player.x - ring_w/2, game->player.y - ring_h/2, ring_w, ring_h }), 1, GRAY);
+    DrawRectangleLinesEx(dst, 1, BLACK);
+}
@@ -0,0 +1,57 @@
+#ifndef _MINIMAP_H_
+#define _MINIMAP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+/*
+    where the enemies are, out past the spawn ring, in the corner.
+
+    it's a small image redrawn every interval (not every frame): every
+    enemy's position is splatted into a count per pixel, 4 at a time, the
+    counts go through a colour ramp, and the result goes up as one texture
+    upload. drawing it is one textured quad and a few outlines, however
+    many enemies there are.
+
+    splat_secs and upload_secs are what the last redraw cost, shown with
+    the metrics (F3) and kept per frame by the flight recorder.
+*/
+
+/* counts past the end of the ramp get its last colour */
+#define MINIMAP_RAMP 64
+
+typedef struct Game Game;
+
+typedef struct {
+    /* pixels a side */
+    int size;
+    /* how far it sees, in spawn rings (screen_margin[1]) */
+    float range;
+    /* seconds of gametime between redraws */
+    float interval;
+    /* how big it's drawn, % of the screen height */
+    float screen_size;
+} MinimapConfig;
+
+typedef struct {
+    /* enemies per pixel, size * size */
+    uint16_t *density;
+    Color *pixels;
+    Color ramp[MINIMAP_RAMP];
+    Texture2D texture;
+    bool loaded;
+    /* the part of the world the image is of, centred on the player
+       when it was redrawn */
+    Rectangle area;
+    float last_update;
+    double splat_secs, upload_secs;
+} Minimap;
+
+void UnloadMinimap(Game*);
+
+/* redraws the image if it's due, then draws it */
+void DrawMinimap(Game*);
+
+#endif /* _MINIMAP_H_ */
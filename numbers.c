@@ -0,0 +1,114 @@
+#include "numbers.h"
+#include "game.h"
+
+void ClearDamageNumbers(Game *game) {
+    DamageNumbers *n = &game->numbers;
+
+    memset(n->ring, 0, sizeof(n->ring));
+    memset(n->slot, 0, sizeof(n->slot));
+    n->head = 0;
+}
+
+void UnloadDamageNumbers(Game *game) {
+    if (game->numbers.atlas_loaded) {
+        UnloadTexture(game->numbers.atlas);
+        game->numbers.atlas_loaded = false;
+    }
+}
+
+/* white digits with a black outline, in cells as wide as the widest */
+static void load_atlas(Game *game) {
+    DamageNumbers *n = &game->numbers;
+    int size = game->config.numbers.font_size;
+    char digit[2] = "0";
+    Image atlas, glyph;
+    Rectangle src;
+
+    n->digit_w = 0;
+    for (int d = 0; d < 10; d++) {
+        digit[0] = '0' + d;
+        n->digit_w = fmaxf(n->digit_w, MeasureText(digit, size));
+    }
+    // room for the outline on each side
+    n->digit_w += 2;
+    n->digit_h = size + 2;
+
+    atlas = GenImageColor(10 * n->digit_w, n->digit_h, BLANK);
+    for (int d = 0; d < 10; d++) {
+        digit[0] = '0' + d;
+        glyph = ImageText(digit, size, WHITE);
+        src = (Rectangle){ 0, 0, glyph.width, glyph.height };
+        for (int ox = -1; ox <= 1; ox++) {
+            for (int oy = -1; oy <= 1; oy++) {
+                ImageDraw(&atlas, glyph, src, (Rectangle){ d * n->digit_w + 1 + ox, 1 + oy, glyph.width, glyph.height }, BLACK);
+            }
+        }
+        ImageDraw(&atlas, glyph, src, (Rectangle){ d * n->digit_w + 1, 1, glyph.width, glyph.height }, WHITE);
+        UnloadImage(glyph);
+    }
+    n->atlas = LoadTextureFromImage(atlas);
+    n->atlas_loaded = true;
+    UnloadImage(atlas);
+}
+
+void ShowDamage(Game *game, unsigned int id, float x, float y, int amount) {
+    DamageNumbers *n = &game->numbers;
+    short *slot = &n->slot[id & (DAMAGE_NUMBER_SLOTS - 1)];
+    DamageNumber *d = &n->ring[*slot];
+
+    // nothing draws them
+    if (game->headless) {
+        return;
+    }
+    if (d->target == id && game->ui.gametime - d->born < game->config.numbers.window) {
+        d->amount += amount;
+        return;
+    }
+
+    n->ring[n->head] = (DamageNumber){ id, x, y, amount, game->ui.gametime };
+    *slot = n->head;
+    n->head = (n->head + 1) % DAMAGE_NUMBERS;
+}
+
+void DrawDamageNumbers(Game *game) {
+    DamageNumbers *n = &game->numbers;
+    DamageNumberConfig *c = &game->config.numbers;
+    Rectangle view = screen_view(game);
+    DamageNumber *d;
+    char digits[12];
+    int count, amount;
+    float age, x, y;
+    Color tint;
+
+    if (!n->atlas_loaded) {
+        load_atlas(game);
+    }
+
+    for (int i = 0; i < DAMAGE_NUMBERS; i++) {
+        d = &n->ring[i];
+        age = game->ui.gametime - d->born;
+        if (d->target == 0 || age >= c->lifetime) {
+            continue;
+        }
+        y = d->y - c->rise * age;
+        if (!CheckCollisionPointRec((Vector2){ d->x, y }, view)) {
+            continue;
+        }
+
+        // least significant first
+        count = 0;
+        amount = d->amount > 0 ? d->amount : 0;
+        do {
+            digits[count++] = amount % 10;
+            amount /= 10;
+        } while (amount > 0 && count < len(digits));
+
+        x = d->x + count * n->digit_w / 2.0f;
+        tint = Fade(WHITE, 1 - age / c->lifetime);
+        for (int k = 0; k < count; k++) {
+            x -= n->digit_w;
+            DrawTextureRec(n->atlas, (Rectangle){ digits[k] * n->digit_w, 0, n->digit_w, n->digit_h },
+                (Vector2){ x, y - n->digit_h / 2.0f }, tint);
+        }
+    }
+}
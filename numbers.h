@@ -0,0 +1,72 @@
+#ifndef _NUMBERS_H_
+#define _NUMBERS_H_
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+/*
+    floating damage numbers.
+
+    they live in a fixed ring, a new one goes over the oldest. hits on the
+    same enemy within window of its number's first hit are added to that
+    number instead of making another, so an explosion going off over a
+    crowd is one number per enemy, not one per enemy per tick.
+
+    finding an enemy's number is one lookup: slot remembers the ring slot
+    last used for each id (hashed), and it only counts if the number
+    there is still that enemy's.
+
+    digits come from an atlas rasterised once (with an outline so they
+    read on any background), and every digit of every number is a
+    DrawTextureRec from it, back to back, which raylib puts in a single
+    batch since the texture never changes in between.
+*/
+
+/* ring size */
+#define DAMAGE_NUMBERS 512
+/* id hash size, power of 2 */
+#define DAMAGE_NUMBER_SLOTS 1024
+
+typedef struct Game Game;
+
+typedef struct {
+    /* seconds hits on one enemy are added together for */
+    float window;
+    /* seconds each is up for, fading out */
+    float lifetime;
+    /* px per second upwards */
+    float rise;
+    int font_size;
+} DamageNumberConfig;
+
+typedef struct {
+    /* enemy id, 0 = unused */
+    unsigned int target;
+    float x, y;
+    int amount;
+    /* gametime of the first hit */
+    float born;
+} DamageNumber;
+
+typedef struct {
+    DamageNumber ring[DAMAGE_NUMBERS];
+    /* where the next one goes */
+    int head;
+    /* ring slot by id & (DAMAGE_NUMBER_SLOTS - 1) */
+    short slot[DAMAGE_NUMBER_SLOTS];
+
+    /* 0-9 left to right, digit_w apart */
+    Texture2D atlas;
+    bool atlas_loaded;
+    int digit_w, digit_h;
+} DamageNumbers;
+
+void ClearDamageNumbers(Game*);
+void UnloadDamageNumbers(Game*);
+
+/* id is the enemy's, x and y where the number starts */
+void ShowDamage(Game*, unsigned int id, float x, float y, int amount);
+void DrawDamageNumbers(Game*);
+
+#endif /* _NUMBERS_H_ */
@@ -0,0 +1,119 @@
+#include "quality.h"
+#include "game.h"
+
+/* DrawCircle's own segment count, at or above this just call it */
+#define FULL_CIRCLE_SEGMENTS 36
+
+static const char *quality_names[QUALITY_COUNT] = {
+    [QUALITY_HIGH] = "high",
+    [QUALITY_MEDIUM] = "medium",
+    [QUALITY_LOW] = "low",
+    [QUALITY_LOWEST] = "lowest",
+};
+
+void InitQuality(Game *game) {
+    game->quality = (QualityGovernor){ .level = QUALITY_HIGH, .headroom = 1.0f };
+}
+
+void UnloadQuality(Game *game) {
+    if (game->quality.target_loaded) {
+        UnloadRenderTexture(game->quality.target);
+        game->quality.target_loaded = false;
+    }
+}
+
+const QualitySettings *QualitySetting(Game *game) {
+    return &game->config.quality.levels[game->quality.level];
+}
+
+const char *QualityName(QualityLevel level) {
+    return quality_names[level];
+}
+
+void UpdateQuality(Game *game, double frame_secs) {
+    QualityGovernor *q = &game->quality;
+    QualityConfig *c = &game->config.quality;
+    /* frame_secs is only the work, the frame itself lasts this long */
+    float dt = 1.0f / game->config.target_fps;
+    float load;
+
+    q->frame_time += (frame_secs - q->frame_time) * c->smoothing;
+    load = q->frame_time / c->frame_budget;
+    q->headroom = 1.0f - load;
+
+    if (load > c->step_down_at) {
+        q->over_secs += dt;
+        q->under_secs = 0;
+    } else if (load < c->step_up_at) {
+        q->under_secs += dt;
+        q->over_secs = 0;
+    } else {
+        q->over_secs = q->under_secs = 0;
+    }
+
+    if (q->over_secs >= c->step_down_secs && q->level < QUALITY_COUNT - 1) {
+        q->level++;
+        q->over_secs = 0;
+    } else if (q->under_secs >= c->step_up_secs && q->level > QUALITY_HIGH) {
+        q->level--;
+        q->under_secs = 0;
+    }
+}
+
+void BeginWorldMode(Game *game) {
+    QualityGovernor *q = &game->quality;
+    float scale = QualitySetting(game)->render_scale;
+    Camera2D camera = game->camera;
+    int w, h;
+
+    q->drawing_scaled = scale < 1.0f;
+    if (!q->drawing_scaled) {
+        BeginMode2D(camera);
+        return;
+    }
+
+    w = screensize(game).x * scale;
+    h = screensize(game).y * scale;
+    if (!q->target_loaded || q->target.texture.width != w || q->target.texture.height != h) {
+        UnloadQuality(game);
+        q->target = LoadRenderTexture(w, h);
+        SetTextureFilter(q->target.texture, TEXTURE_FILTER_BILINEAR);
+        q->target_loaded = true;
+    }
+
+    /* same view of the world, just fewer pixels */
+    camera.offset = (Vector2){ w / 2.0f, h / 2.0f };
+    camera.zoom *= scale;
+
+    BeginTextureMode(q->target);
+    ClearBackground(RAYWHITE);
+    BeginMode2D(camera);
+}
+
+void EndWorldMode(Game *game) {
+    QualityGovernor *q = &game->quality;
+    Texture2D t = q->target.texture;
+
+    EndMode2D();
+    if (!q->drawing_scaled) {
+        return;
+    }
+    EndTextureMode();
+
+    /* render textures are upside down */
+    DrawTexturePro(t,
+        (Rectangle){ 0, 0, t.width, -t.height },
+        (Rectangle){ 0, 0, screensize(game).x, screensize(game).y },
+        (Vector2){ 0, 0 }, 0, WHITE
+    );
+}
+
+void DrawCircleQ(Game *game, float x, float y, float radius, Color color) {
+    int segments = QualitySetting(game)->circle_segments;
+
+    if (segments >= FULL_CIRCLE_SEGMENTS) {
+        DrawCircle(x, y, radius, color);
+    } else {
+        DrawCircleSector((Vector2){ x, y }, radius, 0, 360, segments, color);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef _QUALITY_H_
+#define _QUALITY_H_
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+/*
+    quality governor: trades looks for frame time.
+
+    every gameplay frame it's told how long the frame's work took (before
+    the vsync/target fps wait). if the average stays over step_down_at of
+    the budget for step_down_secs it drops a level, if it stays under
+    step_up_at for step_up_secs it goes back up one. the gap between the
+    two thresholds and the longer wait going up keep it from flapping.
+
+    each level is a QualitySettings, everything that draws or spawns
+    cosmetic stuff asks QualitySetting(game) what it's allowed to do.
+*/
+
+typedef struct Game Game;
+
+typedef enum {
+    QUALITY_HIGH = 0,
+    QUALITY_MEDIUM,
+    QUALITY_LOW,
+    QUALITY_LOWEST,
+    /* how many there are */
+    QUALITY_COUNT,
+} QualityLevel;
+
+typedef struct {
+    /* enemy fadeouts that can start per tick and be alive at once, -1 = no limit */
+    int fadeouts_per_tick;
+    int max_fadeouts;
+    /* raylib's DrawCircle uses 36 */
+    int circle_segments;
+    /* the world is drawn at this fraction of the window and scaled up */
+    float render_scale;
+    /* show_hitboxes only does anything if this is set */
+    bool hitboxes;
+} QualitySettings;
+
+typedef struct {
+    /* seconds of work per frame we're aiming for */
+    float frame_budget;
+    /* fractions of frame_budget */
+    float step_down_at, step_up_at;
+    /* how long it has to stay past a threshold before changing level */
+    float step_down_secs, step_up_secs;
+    /* how much of each new frame time goes into the average, 0-1 */
+    float smoothing;
+    QualitySettings levels[QUALITY_COUNT];
+} QualityConfig;
+
+typedef struct {
+    QualityLevel level;
+    /* metrics: moving average of frame work time, and 1 - that / budget */
+    float frame_time;
+    float headroom;
+    /* how long we've been over/under the thresholds */
+    float over_secs, under_secs;
+    int fadeouts_this_tick;
+
+    /* for render_scale < 1 */
+    RenderTexture2D target;
+    bool target_loaded;
+    bool drawing_scaled;
+} QualityGovernor;
+
+void InitQuality(Game*);
+void UnloadQuality(Game*);
+/* once per gameplay frame */
+void UpdateQuality(Game*, double frame_secs);
+const QualitySettings *QualitySetting(Game*);
+const char *QualityName(QualityLevel);
+
+/* use instead of BeginMode2D/EndMode2D for the world */
+void BeginWorldMode(Game*);
+void EndWorldMode(Game*);
+
+/* DrawCircle at the current circle detail */
+void DrawCircleQ(Game*, float x, float y, float radius, Color);
+
+#endif /* _QUALITY_H_ */
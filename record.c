@@ -0,0 +1,362 @@
+#include "record.h"
+
+static int32_t quantize(float v) {
+    return (int32_t) lroundf(v * RECORD_QUANT);
+}
+
+static RecEntity rec_entity(Entity *e) {
+    return (RecEntity){ e->id, quantize(e->x), quantize(e->y), e->hp };
+}
+
+static int compare_rec_entity(const void *a, const void *b) {
+    uint32_t ia = ((const RecEntity *) a)->id;
+    uint32_t ib = ((const RecEntity *) b)->id;
+    return (ia > ib) - (ia < ib);
+}
+
+/* writer thread */
+
+/* small moves with no hp change fit in one byte */
+static void put_residual(vec_char_t *out, int32_t rx, int32_t ry, int32_t rhp) {
+    if (rhp == 0 && abs(rx) <= RECORD_SMALL_RESIDUAL && abs(ry) <= RECORD_SMALL_RESIDUAL) {
+        vec_push(out, (char) ((rx + RECORD_SMALL_RESIDUAL) * RECORD_SMALL_SPAN + (ry + RECORD_SMALL_RESIDUAL)));
+    } else {
+        vec_push(out, (char) RECORD_RESIDUAL_ESCAPE);
+        put_svarint(out, rx);
+        put_svarint(out, ry);
+        put_svarint(out, rhp);
+    }
+}
+
+static void flush_chunk(Recorder *r) {
+    RecChunkHeader h;
+    unsigned char *packed = NULL;
+    int packed_size = 0;
+
+    if (r->chunk_ticks == 0) {
+        return;
+    }
+
+    memcpy(h.magic, RECORD_CHUNK_MAGIC, 4);
+    h.first_tick = r->chunk_first_tick;
+    h.ticks = r->chunk_ticks;
+    h.raw_size = r->chunk.length;
+    h.compressed = 0;
+
+    packed = CompressData((unsigned char *) r->chunk.data, r->chunk.length, &packed_size);
+    if (packed != NULL && packed_size > 0 && packed_size < r->chunk.length) {
+        h.compressed = 1;
+        h.stored_size = packed_size;
+        fwrite(&h, sizeof(h), 1, r->file);
+        fwrite(packed, 1, packed_size, r->file);
+    } else {
+        h.stored_size = r->chunk.length;
+        fwrite(&h, sizeof(h), 1, r->file);
+        fwrite(r->chunk.data, 1, r->chunk.length, r->file);
+    }
+    MemFree(packed);
+
+    r->bytes_written += sizeof(h) + h.stored_size;
+    vec_clear(&r->chunk);
+    r->chunk_ticks = 0;
+}
+
+static void encode_spawns(vec_char_t *out, RecFrame *f) {
+    put_uvarint(out, f->spawns.length);
+    for (int i = 0; i < f->spawns.length; i++) {
+        vec_push(out, (char) f->spawns.data[i].type);
+        put_svarint(out, f->spawns.data[i].x - f->player.x);
+        put_svarint(out, f->spawns.data[i].y - f->player.y);
+    }
+}
+
+static void encode_keyframe(Recorder *r, RecFrame *f) {
+    vec_char_t *out = &r->chunk;
+    RecEntityVec *cur;
+    RecTrackVec *tracks;
+    uint32_t last_id;
+
+    put_uvarint(out, f->tick);
+    put_svarint(out, f->player.x);
+    put_svarint(out, f->player.y);
+    put_svarint(out, f->player.hp);
+
+    for (int t = 0; t < E_COUNT; t++) {
+        cur = &f->entities[t];
+        tracks = &r->tracks[t];
+        vec_clear(tracks);
+        last_id = 0;
+
+        put_uvarint(out, cur->length);
+        for (int i = 0; i < cur->length; i++) {
+            RecEntity *e = &cur->data[i];
+            put_uvarint(out, e->id - last_id);
+            put_svarint(out, e->x);
+            put_svarint(out, e->y);
+            put_svarint(out, e->hp);
+            last_id = e->id;
+            /* velocity starts over so decoding can begin here */
+            vec_push(tracks, ((RecTrack){ e->id, e->x, e->y, e->hp, 0, 0 }));
+        }
+    }
+
+    encode_spawns(out, f);
+}
+
+static void encode_delta(Recorder *r, RecFrame *f) {
+    vec_char_t *out = &r->chunk;
+    vec_char_t *runs = &r->scratch;
+    RecEntityVec *cur;
+    RecTrackVec *tracks, *next_tracks = &r->next_tracks;
+    RecTrack *prev;
+    uint32_t last_removed, last_spawned;
+    int removed, spawned, skip, i, j;
+    int32_t rx, ry, rhp;
+
+    put_uvarint(out, f->tick - r->last_tick);
+    put_svarint(out, f->player.x - r->last_player.x);
+    put_svarint(out, f->player.y - r->last_player.y);
+    put_svarint(out, f->player.hp - r->last_player.hp);
+
+    for (int t = 0; t < E_COUNT; t++) {
+        cur = &f->entities[t];
+        tracks = &r->tracks[t];
+
+        /* removed ids (in tracks but not in cur) */
+        removed = 0;
+        for (i = 0, j = 0; i < tracks->length; i++) {
+            while (j < cur->length && cur->data[j].id < tracks->data[i].id) j++;
+            if (j == cur->length || cur->data[j].id != tracks->data[i].id) removed++;
+        }
+        put_uvarint(out, removed);
+        last_removed = 0;
+        for (i = 0, j = 0; i < tracks->length; i++) {
+            while (j < cur->length && cur->data[j].id < tracks->data[i].id) j++;
+            if (j == cur->length || cur->data[j].id != tracks->data[i].id) {
+                put_uvarint(out, tracks->data[i].id - last_removed);
+                last_removed = tracks->data[i].id;
+            }
+        }
+
+        /* spawned ids (in cur but not in tracks) */
+        spawned = 0;
+        for (i = 0, j = 0; j < cur->length; j++) {
+            while (i < tracks->length && tracks->data[i].id < cur->data[j].id) i++;
+            if (i == tracks->length || tracks->data[i].id != cur->data[j].id) spawned++;
+        }
+        put_uvarint(out, spawned);
+        last_spawned = 0;
+        for (i = 0, j = 0; j < cur->length; j++) {
+            while (i < tracks->length && tracks->data[i].id < cur->data[j].id) i++;
+            if (i == tracks->length || tracks->data[i].id != cur->data[j].id) {
+                put_uvarint(out, cur->data[j].id - last_spawned);
+                put_svarint(out, cur->data[j].x);
+                put_svarint(out, cur->data[j].y);
+                put_svarint(out, cur->data[j].hp);
+                last_spawned = cur->data[j].id;
+            }
+        }
+
+        /* survivors, building next tick's tracks as we go */
+        vec_clear(runs);
+        vec_clear(next_tracks);
+        skip = 0;
+        for (i = 0, j = 0; j < cur->length; j++) {
+            RecEntity *e = &cur->data[j];
+            while (i < tracks->length && tracks->data[i].id < e->id) i++;
+
+            if (i < tracks->length && tracks->data[i].id == e->id) {
+                prev = &tracks->data[i];
+                rx = e->x - (prev->x + prev->vx);
+                ry = e->y - (prev->y + prev->vy);
+                rhp = e->hp - prev->hp;
+                if (rx == 0 && ry == 0 && rhp == 0) {
+                    skip++;
+                } else {
+                    put_uvarint(runs, skip);
+                    put_residual(runs, rx, ry, rhp);
+                    skip = 0;
+                }
+                vec_push(next_tracks, ((RecTrack){ e->id, e->x, e->y, e->hp, e->x - prev->x, e->y - prev->y }));
+            } else {
+                vec_push(next_tracks, ((RecTrack){ e->id, e->x, e->y, e->hp, 0, 0 }));
+            }
+        }
+        put_uvarint(runs, skip);
+        vec_extend(out, runs);
+
+        /* swap so both vecs keep their storage */
+        {
+            RecTrackVec tmp = *tracks;
+            *tracks = *next_tracks;
+            *next_tracks = tmp;
+        }
+    }
+
+    encode_spawns(out, f);
+}
+
+static void encode_frame(Recorder *r, RecFrame *f) {
+    for (int t = 0; t < E_COUNT; t++) {
+        vec_sort(&f->entities[t], compare_rec_entity);
+    }
+
+    if (r->chunk_ticks >= RECORD_KEYFRAME_TICKS) {
+        flush_chunk(r);
+    }
+    if (r->chunk_ticks == 0) {
+        r->chunk_first_tick = f->tick;
+        encode_keyframe(r, f);
+    } else {
+        encode_delta(r, f);
+    }
+
+    r->chunk_ticks++;
+    r->last_tick = f->tick;
+    r->last_player = f->player;
+}
+
+static void *writer_thread(void *arg) {
+    Recorder *r = arg;
+    RecFrame *f;
+
+    pthread_mutex_lock(&r->lock);
+    while (true) {
+        while (r->count == 0 && !r->stop) {
+            pthread_cond_wait(&r->cond, &r->lock);
+        }
+        if (r->count == 0 && r->stop) {
+            break;
+        }
+        f = &r->frames[r->head];
+        pthread_mutex_unlock(&r->lock);
+
+        /* the main thread never touches the head frame */
+        encode_frame(r, f);
+
+        pthread_mutex_lock(&r->lock);
+        r->head = (r->head + 1) % RECORD_QUEUE;
+        r->count--;
+    }
+    pthread_mutex_unlock(&r->lock);
+
+    flush_chunk(r);
+    return NULL;
+}
+
+/* main thread */
+
+Recorder *StartRecording(const char *path) {
+    Recorder *r;
+    RecFileHeader h = {0};
+    FILE *f;
+
+    if ((f = fopen(path, "wb")) == NULL) {
+        fprintf(stderr, "Could not open recording: %s\n", path);
+        return NULL;
+    }
+
+    memcpy(h.magic, RECORD_MAGIC, 4);
+    h.version = RECORD_VERSION;
+    h.quant = RECORD_QUANT;
+    h.entity_types = E_COUNT;
+    h.particle_types = P_COUNT;
+    h.keyframe_ticks = RECORD_KEYFRAME_TICKS;
+    fwrite(&h, sizeof(h), 1, f);
+
+    r = MemAlloc(sizeof(Recorder));
+    r->file = f;
+    r->bytes_written = sizeof(h);
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    pthread_create(&r->thread, NULL, writer_thread, r);
+    return r;
+}
+
+void StopRecording(Recorder *r) {
+    if (r == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    r->stop = true;
+    pthread_cond_signal(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    pthread_join(r->thread, NULL);
+
+    fclose(r->file);
+    fprintf(stderr, "Recorded %u ticks (%d dropped), %ld bytes\n", r->tick, r->dropped, r->bytes_written);
+
+    for (int i = 0; i < RECORD_QUEUE; i++) {
+        for (int t = 0; t < E_COUNT; t++) {
+            vec_deinit(&r->frames[i].entities[t]);
+        }
+        vec_deinit(&r->frames[i].spawns);
+    }
+    for (int t = 0; t < E_COUNT; t++) {
+        vec_deinit(&r->tracks[t]);
+    }
+    vec_deinit(&r->next_tracks);
+    vec_deinit(&r->pending_spawns);
+    vec_deinit(&r->chunk);
+    vec_deinit(&r->scratch);
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->cond);
+    MemFree(r);
+}
+
+void RecordParticleSpawn(Recorder *r, ParticleType type, float x, float y) {
+    vec_push(&r->pending_spawns, ((RecParticle){ type, quantize(x), quantize(y) }));
+}
+
+void RecordTick(Recorder *r, Game *game) {
+    RecFrame *f;
+    RecEntityVec *dst;
+    EntityVec *src;
+    int count, tail;
+
+    r->tick++;
+
+    pthread_mutex_lock(&r->lock);
+    count = r->count;
+    tail = (r->head + r->count) % RECORD_QUEUE;
+    pthread_mutex_unlock(&r->lock);
+
+    if (count == RECORD_QUEUE) {
+        /* writer is behind, skip this tick rather than wait */
+        r->dropped++;
+        vec_clear(&r->pending_spawns);
+        return;
+    }
+
+    /* the tail slot stays put while the writer pops from the head */
+    f = &r->frames[tail];
+    f->tick = r->tick;
+    f->player = rec_entity(&game->player);
+
+    for (int t = 0; t < E_COUNT; t++) {
+        src = &game->entities[t];
+        dst = &f->entities[t];
+        vec_clear(dst);
+        if (src->length > 0) {
+            vec_reserve(dst, src->length);
+            for (int i = 0; i < src->length; i++) {
+                dst->data[i] = rec_entity(&src->data[i]);
+            }
+            dst->length = src->length;
+        }
+    }
+
+    /* swap so neither vec has to be copied */
+    {
+        RecParticleVec tmp = f->spawns;
+        f->spawns = r->pending_spawns;
+        r->pending_spawns = tmp;
+        vec_clear(&r->pending_spawns);
+    }
+
+    pthread_mutex_lock(&r->lock);
+    r->count++;
+    pthread_cond_signal(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
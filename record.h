@@ -0,0 +1,176 @@
+#ifndef _RECORD_H_
+#define _RECORD_H_
+
+#include <pthread.h>    /* pthread_t, pthread_mutex_t, pthread_cond_t */
+#include <stdint.h>
+
+#include "game.h"
+
+/*
+    per-tick state stream for offline analysis.
+
+    the tick loop only copies (id, x, y, hp) of every entity into a queued
+    frame, a background thread does the encoding, DEFLATE and disk writes.
+    if the queue is full the tick is dropped (it shows up as a gap in the
+    tick numbers), the game never waits on the disk.
+
+    file:   RecFileHeader, then chunks
+    chunk:  RecChunkHeader, then payload (raw or DEFLATE'd tick records)
+            every chunk starts with a keyframe, so you can seek to any
+            chunk and decode from there
+
+    tick record (all ints are LEB128 varints, signed ones zigzagged,
+    positions are in 1/RECORD_QUANT pixels):
+
+    keyframe (first tick of a chunk):
+        tick
+        player x, y, hp
+        per entity type: count, then (id delta, x, y, hp) sorted by id
+        particle spawns: count, then (type byte, x, y relative to player)
+
+    delta (every other tick):
+        tick delta
+        player dx, dy, dhp
+        per entity type:
+            removed count, removed id deltas
+            spawned count, (id delta, x, y, hp)
+            survivors in id order as runs: skip count, then one
+            (x, y, hp residual) record, until the skips cover them all.
+            the residual is against last position + last velocity, so
+            anything moving in a straight line costs nothing.
+            a residual is one byte (rx + 3) * 7 + (ry + 3) when both are
+            within +-3 and hp didn't change, otherwise the escape byte
+            followed by x, y, hp
+        particle spawns: same as keyframe
+*/
+
+#define RECORD_MAGIC "MSST"
+#define RECORD_CHUNK_MAGIC "MSCK"
+#define RECORD_VERSION 1
+#define RECORD_QUANT 4
+/* 5 seconds at 60 fps */
+#define RECORD_KEYFRAME_TICKS 300
+/* see put_residual */
+#define RECORD_SMALL_RESIDUAL 3
+#define RECORD_SMALL_SPAN (2 * RECORD_SMALL_RESIDUAL + 1)
+#define RECORD_RESIDUAL_ESCAPE (RECORD_SMALL_SPAN * RECORD_SMALL_SPAN)
+/* frames waiting for the writer thread */
+#define RECORD_QUEUE 16
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t quant;
+    uint32_t entity_types;
+    uint32_t particle_types;
+    uint32_t keyframe_ticks;
+} RecFileHeader;
+
+typedef struct {
+    char magic[4];
+    uint32_t first_tick;
+    uint32_t ticks;
+    uint32_t raw_size;
+    uint32_t stored_size;
+    /* 1 if the payload is DEFLATE'd */
+    uint32_t compressed;
+} RecChunkHeader;
+
+typedef struct {
+    uint32_t id;
+    int32_t x, y, hp;
+} RecEntity;
+
+typedef struct {
+    int32_t type;
+    int32_t x, y;
+} RecParticle;
+
+typedef vec_t(RecEntity) RecEntityVec;
+typedef vec_t(RecParticle) RecParticleVec;
+
+typedef struct {
+    uint32_t tick;
+    RecEntity player;
+    RecEntityVec entities[E_COUNT];
+    RecParticleVec spawns;
+} RecFrame;
+
+/* what the encoder remembers about an entity between ticks */
+typedef struct {
+    uint32_t id;
+    int32_t x, y, hp;
+    int32_t vx, vy;
+} RecTrack;
+
+typedef vec_t(RecTrack) RecTrackVec;
+
+struct Recorder {
+    FILE *file;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    /* ring of filled frames, [head, head + count) */
+    RecFrame frames[RECORD_QUEUE];
+    int head, count;
+    bool stop;
+
+    /* main thread only */
+    uint32_t tick;
+    RecParticleVec pending_spawns;
+    int dropped;
+
+    /* writer thread only */
+    RecTrackVec tracks[E_COUNT], next_tracks;
+    RecEntity last_player;
+    uint32_t last_tick;
+    vec_char_t chunk, scratch;
+    uint32_t chunk_first_tick, chunk_ticks;
+    long bytes_written;
+};
+
+Recorder *StartRecording(const char *path);
+void StopRecording(Recorder*);
+
+void RecordTick(Recorder*, Game*);
+void RecordParticleSpawn(Recorder*, ParticleType, float x, float y);
+
+/* varints, shared with utils/streamdump.c */
+
+static inline void put_uvarint(vec_char_t *buf, uint32_t v) {
+    while (v >= 0x80) {
+        vec_push(buf, (char) (v | 0x80));
+        v >>= 7;
+    }
+    vec_push(buf, (char) v);
+}
+
+static inline void put_svarint(vec_char_t *buf, int32_t v) {
+    put_uvarint(buf, ((uint32_t) v << 1) ^ (uint32_t) (v >> 31));
+}
+
+/* returns false if it runs off the end of the buffer */
+static inline bool get_uvarint(const unsigned char **p, const unsigned char *end, uint32_t *v) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && *p < end; shift += 7) {
+        unsigned char byte = *(*p)++;
+        result |= (uint32_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool get_svarint(const unsigned char **p, const unsigned char *end, int32_t *v) {
+    uint32_t u;
+    if (!get_uvarint(p, end, &u)) {
+        return false;
+    }
+    *v = (int32_t) (u >> 1) ^ -(int32_t) (u & 1);
+    return true;
+}
+
+#endif /* _RECORD_H_ */
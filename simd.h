@@ -0,0 +1,40 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <string.h>     /* memcpy */
+
+/*
+    4 floats (or ints) side by side. GCC and clang turn arithmetic and
+    comparisons on these into SSE/NEON. comparing two v4f gives a v4i
+    with -1 in the lanes where it held and 0 elsewhere, so masks combine
+    with & and |.
+*/
+
+typedef float v4f __attribute__((vector_size(16)));
+typedef int v4i __attribute__((vector_size(16)));
+
+/* unaligned, so any 4 floats in a row will do */
+static inline v4f load4(const float *p) {
+    v4f v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store4(float *p, v4f v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline v4f splat4(float f) {
+    return (v4f){ f, f, f, f };
+}
+
+static inline v4i splat4i(int n) {
+    return (v4i){ n, n, n, n };
+}
+
+/* v where mask is set, 0 elsewhere */
+static inline v4f select4(v4i mask, v4f v) {
+    return (v4f) ((v4i) v & mask);
+}
+
+#endif /* _SIMD_H_ */
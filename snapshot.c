@@ -0,0 +1,355 @@
+#include "snapshot.h"
+
+#include <fcntl.h>      /* open */
+#include <sys/mman.h>   /* mmap, munmap */
+#include <sys/stat.h>   /* fstat */
+
+_Static_assert(sizeof(GameTimers) % sizeof(Timer) == 0, "GameTimers must only hold Timers");
+_Static_assert(sizeof(GameTimers) / sizeof(Timer) <= 8, "SnapshotHeader.timers is too small");
+
+static uint64_t align_up(uint64_t n) {
+    return (n + SNAPSHOT_ALIGN - 1) & ~(uint64_t)(SNAPSHOT_ALIGN - 1);
+}
+
+/* HostileShots' arrays in the order they're saved */
+static void hostile_arrays(HostileShots *s, float *arrays[4]) {
+    arrays[0] = s->x;
+    arrays[1] = s->y;
+    arrays[2] = s->vx;
+    arrays[3] = s->vy;
+}
+
+static void write_padding(FILE *f, uint64_t *pos) {
+    static const char zeros[SNAPSHOT_ALIGN] = {0};
+    uint64_t next = align_up(*pos);
+    fwrite(zeros, 1, next - *pos, f);
+    *pos = next;
+}
+
+bool SaveSnapshot(Game *game, const char *path) {
+    SnapshotHeader h = {0};
+    Timer *timers = (Timer *) &game->timers;
+    float *hostile[4];
+    int hit_total = 0;
+    uint64_t pos;
+    FILE *f;
+
+    memcpy(h.magic, SNAPSHOT_MAGIC, 4);
+    h.version = SNAPSHOT_VERSION;
+    h.header_size = sizeof(SnapshotHeader);
+    h.timer_count = SNAPSHOT_TIMER_COUNT;
+    h.state = game->state;
+    h.gametime = game->ui.gametime;
+    h.rng = game->rng;
+    h.next_id = game->next_id;
+    h.xp = game->xp;
+    h.player = game->player;
+    h.camera = game->camera;
+    h.director = game->director;
+    memcpy(h.weapons, game->weapons, sizeof(h.weapons));
+
+    for (int i = 0; i < SNAPSHOT_TIMER_COUNT; i++) {
+        h.timers[i].interval = timers[i].interval;
+        h.timers[i].elapsed = game->ui.gametime - timers[i].last_recorded;
+    }
+
+    /* lay out the blobs first so the header can be written in one go */
+    pos = align_up(sizeof(SnapshotHeader));
+    for (int i = 0; i < E_COUNT; i++) {
+        h.entities[i] = (SnapshotBlob){ pos, game->entities[i].length, sizeof(Entity) };
+        pos = align_up(pos + (uint64_t) game->entities[i].length * sizeof(Entity));
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        h.particles[i] = (SnapshotBlob){ pos, game->particles[i].length, sizeof(Particle) };
+        pos = align_up(pos + (uint64_t) game->particles[i].length * sizeof(Particle));
+    }
+    h.areas = (SnapshotBlob){ pos, game->areas.length, sizeof(AreaDamage) };
+    pos = align_up(pos + (uint64_t) game->areas.length * sizeof(AreaDamage));
+    h.area_hit_counts = (SnapshotBlob){ pos, game->areas.length, sizeof(int32_t) };
+    pos = align_up(pos + (uint64_t) game->areas.length * sizeof(int32_t));
+    for (int i = 0; i < game->areas.length; i++) {
+        hit_total += game->area_hits[i].length;
+    }
+    h.area_hits = (SnapshotBlob){ pos, hit_total, sizeof(unsigned int) };
+    pos = align_up(pos + (uint64_t) hit_total * sizeof(unsigned int));
+    hostile_arrays(&game->hostile, hostile);
+    for (int i = 0; i < 4; i++) {
+        h.hostile[i] = (SnapshotBlob){ pos, game->hostile.count, sizeof(float) };
+        pos = align_up(pos + (uint64_t) game->hostile.count * sizeof(float));
+    }
+    h.gems = (SnapshotBlob){ pos, game->gems.gems.length, sizeof(Gem) };
+    pos = align_up(pos + (uint64_t) game->gems.gems.length * sizeof(Gem));
+    h.pulled = (SnapshotBlob){ pos, game->gems.pulled.length, sizeof(Gem) };
+    pos = align_up(pos + (uint64_t) game->gems.pulled.length * sizeof(Gem));
+    for (int i = 0; i < STATUS_COUNT; i++) {
+        h.status[i] = (SnapshotBlob){ pos, game->status[i].count, sizeof(StatusEntry) };
+        pos = align_up(pos + (uint64_t) game->status[i].count * sizeof(StatusEntry));
+    }
+
+    if ((f = fopen(path, "wb")) == NULL) {
+        fprintf(stderr, "Could not write snapshot: %s\n", path);
+        return false;
+    }
+
+    fwrite(&h, sizeof(h), 1, f);
+    pos = sizeof(h);
+    for (int i = 0; i < E_COUNT; i++) {
+        write_padding(f, &pos);
+        fwrite(game->entities[i].data, sizeof(Entity), game->entities[i].length, f);
+        pos += (uint64_t) game->entities[i].length * sizeof(Entity);
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        write_padding(f, &pos);
+        fwrite(game->particles[i].data, sizeof(Particle), game->particles[i].length, f);
+        pos += (uint64_t) game->particles[i].length * sizeof(Particle);
+    }
+    write_padding(f, &pos);
+    fwrite(game->areas.data, sizeof(AreaDamage), game->areas.length, f);
+    pos += (uint64_t) game->areas.length * sizeof(AreaDamage);
+    write_padding(f, &pos);
+    for (int i = 0; i < game->areas.length; i++) {
+        int32_t count = game->area_hits[i].length;
+        fwrite(&count, sizeof(count), 1, f);
+    }
+    pos += (uint64_t) game->areas.length * sizeof(int32_t);
+    write_padding(f, &pos);
+    for (int i = 0; i < game->areas.length; i++) {
+        fwrite(game->area_hits[i].data, sizeof(unsigned int), game->area_hits[i].length, f);
+    }
+    pos += (uint64_t) hit_total * sizeof(unsigned int);
+    for (int i = 0; i < 4; i++) {
+        write_padding(f, &pos);
+        fwrite(hostile[i], sizeof(float), game->hostile.count, f);
+        pos += (uint64_t) game->hostile.count * sizeof(float);
+    }
+    write_padding(f, &pos);
+    fwrite(game->gems.gems.data, sizeof(Gem), game->gems.gems.length, f);
+    pos += (uint64_t) game->gems.gems.length * sizeof(Gem);
+    write_padding(f, &pos);
+    fwrite(game->gems.pulled.data, sizeof(Gem), game->gems.pulled.length, f);
+    pos += (uint64_t) game->gems.pulled.length * sizeof(Gem);
+    for (int i = 0; i < STATUS_COUNT; i++) {
+        write_padding(f, &pos);
+        fwrite(game->status[i].entries, sizeof(StatusEntry), game->status[i].count, f);
+        pos += (uint64_t) game->status[i].count * sizeof(StatusEntry);
+    }
+
+    fclose(f);
+    return true;
+}
+
+/* checks that a blob is the right kind and lies inside the mapping */
+static bool blob_valid(SnapshotBlob b, int elemsize, size_t filesize) {
+    return b.elemsize == elemsize
+        && b.length >= 0
+        && b.offset % SNAPSHOT_ALIGN == 0
+        && b.offset + (uint64_t) b.length * elemsize <= filesize;
+}
+
+/* the areas' hit sets add up to exactly what's in area_hits */
+static bool hit_counts_valid(const char *base, const SnapshotHeader *h) {
+    const int32_t *counts = (const int32_t *) (base + h->area_hit_counts.offset);
+    int64_t total = 0;
+
+    for (int i = 0; i < h->area_hit_counts.length; i++) {
+        if (counts[i] < 0) {
+            return false;
+        }
+        total += counts[i];
+    }
+    return total == h->area_hits.length;
+}
+
+/* every entry points at an enemy that's in the snapshot */
+static bool status_valid(const char *base, const SnapshotHeader *h, SnapshotBlob b) {
+    const StatusEntry *entries = (const StatusEntry *) (base + b.offset);
+    SpatialRef ref;
+
+    for (int i = 0; i < b.length; i++) {
+        ref = entries[i].enemy;
+        if (ref.type < 0 || ref.type >= E_COUNT || ref.index < 0 || ref.index >= h->entities[ref.type].length) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LoadSnapshot(Game *game, const char *path) {
+    struct stat st;
+    const SnapshotHeader *h;
+    const char *base;
+    Timer *timers = (Timer *) &game->timers;
+    float *hostile[4];
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        fprintf(stderr, "Snapshot not found: %s\n", path);
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(SnapshotHeader)) {
+        fprintf(stderr, "Snapshot too small: %s\n", path);
+        close(fd);
+        return false;
+    }
+
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Could not map snapshot: %s\n", path);
+        return false;
+    }
+    h = (const SnapshotHeader *) base;
+
+    if (memcmp(h->magic, SNAPSHOT_MAGIC, 4) != 0
+        || h->version != SNAPSHOT_VERSION
+        || h->header_size != sizeof(SnapshotHeader)
+        || h->timer_count != (uint32_t) SNAPSHOT_TIMER_COUNT) {
+        fprintf(stderr, "Snapshot has the wrong version: %s\n", path);
+        munmap((void *) base, st.st_size);
+        return false;
+    }
+    for (int i = 0; i < E_COUNT; i++) {
+        if (!blob_valid(h->entities[i], sizeof(Entity), st.st_size)) {
+            fprintf(stderr, "Snapshot is corrupt: %s\n", path);
+            munmap((void *) base, st.st_size);
+            return false;
+        }
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        if (!blob_valid(h->particles[i], sizeof(Particle), st.st_size)) {
+            fprintf(stderr, "Snapshot is corrupt: %s\n", path);
+            munmap((void *) base, st.st_size);
+            return false;
+        }
+    }
+    /* more than the caps would grow the vecs ReserveStorage sized, and the
+       grid and AddEntities count on them never moving */
+    for (int i = 0; i < E_COUNT; i++) {
+        if (h->entities[i].length > game->config.entitydata[i].max_count) {
+            fprintf(stderr, "Snapshot has more than fits: %s\n", path);
+            munmap((void *) base, st.st_size);
+            return false;
+        }
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        if (h->particles[i].length > game->config.particledata[i].max_count) {
+            fprintf(stderr, "Snapshot has more than fits: %s\n", path);
+            munmap((void *) base, st.st_size);
+            return false;
+        }
+    }
+    if (!blob_valid(h->areas, sizeof(AreaDamage), st.st_size)
+        || h->areas.length > game->config.max_areas
+        || !blob_valid(h->area_hit_counts, sizeof(int32_t), st.st_size)
+        || h->area_hit_counts.length != h->areas.length
+        || !blob_valid(h->area_hits, sizeof(unsigned int), st.st_size)
+        || !hit_counts_valid(base, h)) {
+        fprintf(stderr, "Snapshot is corrupt: %s\n", path);
+        munmap((void *) base, st.st_size);
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (!blob_valid(h->hostile[i], sizeof(float), st.st_size)
+            || h->hostile[i].length != h->hostile[0].length
+            || h->hostile[i].length > game->config.hostile.max_shots) {
+            fprintf(stderr, "Snapshot is corrupt: %s\n", path);
+            munmap((void *) base, st.st_size);
+            return false;
+        }
+    }
+    if (!blob_valid(h->gems, sizeof(Gem), st.st_size)
+        || !blob_valid(h->pulled, sizeof(Gem), st.st_size)
+        || h->gems.length > game->gems.gems.capacity
+        || h->pulled.length > game->gems.pulled.capacity) {
+        fprintf(stderr, "Snapshot is corrupt: %s\n", path);
+        munmap((void *) base, st.st_size);
+        return false;
+    }
+    for (int i = 0; i < STATUS_COUNT; i++) {
+        if (!blob_valid(h->status[i], sizeof(StatusEntry), st.st_size)
+            || h->status[i].length > game->status[i].capacity
+            || !status_valid(base, h, h->status[i])) {
+            fprintf(stderr, "Snapshot is corrupt: %s\n", path);
+            munmap((void *) base, st.st_size);
+            return false;
+        }
+    }
+
+    /* pointer fixup: each offset becomes a pointer into the mapping and is
+       copied wholesale into the vec */
+    for (int i = 0; i < E_COUNT; i++) {
+        const Entity *src = (const Entity *) (base + h->entities[i].offset);
+        vec_clear(&game->entities[i]);
+        if (h->entities[i].length > 0) {
+            vec_reserve(&game->entities[i], h->entities[i].length);
+            memcpy(game->entities[i].data, src, h->entities[i].length * sizeof(Entity));
+            game->entities[i].length = h->entities[i].length;
+        }
+    }
+    for (int i = 0; i < P_COUNT; i++) {
+        const Particle *src = (const Particle *) (base + h->particles[i].offset);
+        vec_clear(&game->particles[i]);
+        if (h->particles[i].length > 0) {
+            vec_reserve(&game->particles[i], h->particles[i].length);
+            memcpy(game->particles[i].data, src, h->particles[i].length * sizeof(Particle));
+            game->particles[i].length = h->particles[i].length;
+        }
+    }
+    vec_clear(&game->areas);
+    if (h->areas.length > 0) {
+        vec_reserve(&game->areas, h->areas.length);
+        memcpy(game->areas.data, base + h->areas.offset, h->areas.length * sizeof(AreaDamage));
+        game->areas.length = h->areas.length;
+    }
+    {
+        const int32_t *counts = (const int32_t *) (base + h->area_hit_counts.offset);
+        const unsigned int *ids = (const unsigned int *) (base + h->area_hits.offset);
+
+        for (int i = 0; i < h->areas.length; i++) {
+            vec_clear(&game->area_hits[i]);
+            vec_pusharr(&game->area_hits[i], ids, counts[i]);
+            ids += counts[i];
+        }
+    }
+    hostile_arrays(&game->hostile, hostile);
+    for (int i = 0; i < 4; i++) {
+        memcpy(hostile[i], base + h->hostile[i].offset, h->hostile[i].length * sizeof(float));
+    }
+    game->hostile.count = h->hostile[0].length;
+    /* reserved at max_gems already */
+    memcpy(game->gems.gems.data, base + h->gems.offset, h->gems.length * sizeof(Gem));
+    game->gems.gems.length = h->gems.length;
+    memcpy(game->gems.pulled.data, base + h->pulled.offset, h->pulled.length * sizeof(Gem));
+    game->gems.pulled.length = h->pulled.length;
+    /* the enemies' back pointers came with them */
+    for (int i = 0; i < STATUS_COUNT; i++) {
+        memcpy(game->status[i].entries, base + h->status[i].offset, h->status[i].length * sizeof(StatusEntry));
+        game->status[i].count = h->status[i].length;
+        RebuildStatus(game, i);
+    }
+
+    InitGameTimers(game);
+    for (int i = 0; i < SNAPSHOT_TIMER_COUNT; i++) {
+        timers[i].interval = h->timers[i].interval;
+        timers[i].last_recorded = h->gametime - h->timers[i].elapsed;
+    }
+
+    game->player = h->player;
+    game->camera = h->camera;
+    game->director = h->director;
+    memcpy(game->weapons, h->weapons, sizeof(game->weapons));
+    /* the swing's hit list isn't saved, so a swing doesn't carry over */
+    game->melee.ticks_left = 0;
+    ClearDamageNumbers(game);
+    game->ui.gametime = h->gametime;
+    game->rng = h->rng;
+    game->next_id = h->next_id;
+    game->xp = h->xp;
+    /* the gem grid isn't saved, they're filed again around the player */
+    RefileGems(game);
+    /* come back paused so there's time to get your bearings */
+    game->state = (h->state == GS_GAMEPLAY || h->state == GS_PAUSED) ? GS_PAUSED : h->state;
+
+    munmap((void *) base, st.st_size);
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+/*
+    binary snapshot of the whole simulation state.
+
+    layout: [SnapshotHeader][pad][entity blobs...][particle blobs...][areas]
+    [area hit counts][area hits][hostile x][y][vx][vy][gems][pulled gems]
+    [status entries...]
+    every blob starts on a SNAPSHOT_ALIGN boundary and is a raw copy of
+    the vec's data, so loading is mmap + turning offsets into pointers +
+    one memcpy per vec (no per-entity parsing).
+
+    bump SNAPSHOT_VERSION whenever Entity, Particle, AreaDamage, Gem,
+    StatusEntry, the entity types, the status effects or the header change.
+*/
+
+#define SNAPSHOT_MAGIC "MSSN"
+#define SNAPSHOT_VERSION 11
+#define SNAPSHOT_ALIGN 64
+#define SNAPSHOT_DEFAULT_PATH "./quicksave.snap"
+
+/* one per Timer in GameTimers, in declaration order */
+#define SNAPSHOT_TIMER_COUNT ((int)(sizeof(GameTimers) / sizeof(Timer)))
+
+typedef struct {
+    uint64_t offset;
+    int32_t length;
+    int32_t elemsize;
+} SnapshotBlob;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t timer_count;
+
+    int32_t state;
+    float gametime;
+    uint32_t rng;
+    uint32_t next_id;
+    int32_t xp;
+    Entity player;
+    Camera2D camera;
+    SpawnDirector director;
+    WeaponState weapons[MAX_WEAPONS];
+
+    /* callbacks are function pointers, so only the interval and how far
+       into it each timer was are stored */
+    struct {
+        float interval;
+        float elapsed;
+    } timers[8];
+
+    SnapshotBlob entities[E_COUNT];
+    SnapshotBlob particles[P_COUNT];
+    SnapshotBlob areas;
+    /* how many ids each area's hit set has, then all of them back to back */
+    SnapshotBlob area_hit_counts, area_hits;
+    /* HostileShots' arrays, x, y, vx, vy */
+    SnapshotBlob hostile[4];
+    SnapshotBlob gems, pulled;
+    /* StatusLists' entries, the heaps are rebuilt from them */
+    SnapshotBlob status[STATUS_COUNT];
+} SnapshotHeader;
+
+bool SaveSnapshot(Game*, const char *path);
+bool LoadSnapshot(Game*, const char *path);
+
+#endif /* _SNAPSHOT_H_ */
@@ -0,0 +1,220 @@
+#include "spatial.h"
+
+#include <math.h>       /* asinf, atan2f, ceilf, cosf, fabsf, floorf, fmaxf, fminf, remainderf, sinf, sqrtf */
+
+void InitSpatialGrid(SpatialGrid *grid, float cell_size, int capacity) {
+    *grid = (SpatialGrid){ .cell_size = cell_size };
+    vec_init(&grid->added);
+    vec_init(&grid->start);
+    vec_init(&grid->items);
+    vec_init(&grid->found);
+    vec_reserve(&grid->added, capacity);
+    vec_reserve(&grid->items, capacity);
+    vec_reserve(&grid->found, capacity);
+}
+
+void FreeSpatialGrid(SpatialGrid *grid) {
+    vec_deinit(&grid->added);
+    vec_deinit(&grid->start);
+    vec_deinit(&grid->items);
+    vec_deinit(&grid->found);
+}
+
+static int clamp_cell(float v, float origin, float cell_size, int cells) {
+    int c = (int) floorf((v - origin) / cell_size);
+    return c < 0 ? 0 : c >= cells ? cells - 1 : c;
+}
+
+void BeginSpatialGrid(SpatialGrid *grid, Rectangle bounds) {
+    grid->bounds = bounds;
+    grid->cols = fmaxf(1, ceilf(bounds.width / grid->cell_size));
+    grid->rows = fmaxf(1, ceilf(bounds.height / grid->cell_size));
+    grid->reach = 0;
+    vec_clear(&grid->added);
+    vec_clear(&grid->items);
+    /* only grows when the window does */
+    vec_reserve(&grid->start, grid->cols * grid->rows + 1);
+    grid->start.length = grid->cols * grid->rows + 1;
+    memset(grid->start.data, 0, grid->start.length * sizeof(int));
+}
+
+void SpatialAdd(SpatialGrid *grid, SpatialRef ref, Rectangle box) {
+    int cx = clamp_cell(box.x + box.width / 2, grid->bounds.x, grid->cell_size, grid->cols);
+    int cy = clamp_cell(box.y + box.height / 2, grid->bounds.y, grid->cell_size, grid->rows);
+    SpatialEntry entry = { ref, box, cy * grid->cols + cx };
+
+    grid->reach = fmaxf(grid->reach, fmaxf(box.width, box.height) / 2);
+    grid->start.data[entry.cell + 1]++;
+    vec_push(&grid->added, entry);
+}
+
+void EndSpatialGrid(SpatialGrid *grid) {
+    int *start = grid->start.data;
+    int cells = grid->cols * grid->rows;
+    SpatialEntry *entry;
+    int i;
+
+    for (int c = 0; c < cells; c++) {
+        start[c + 1] += start[c];
+    }
+
+    /* start[c] doubles as the write position for cell c while scattering,
+       which leaves it pointing at the next cell's start, so shift back */
+    vec_reserve(&grid->items, grid->added.length);
+    grid->items.length = grid->added.length;
+    vec_foreach_ptr(&grid->added, entry, i) {
+        grid->items.data[start[entry->cell]++] = *entry;
+    }
+    for (int c = cells; c > 0; c--) {
+        start[c] = start[c - 1];
+    }
+    start[0] = 0;
+}
+
+/* the run of items in the cells look (grown by reach) covers, row by
+   row since each row of cells is contiguous. test says which ones go in found */
+#define query_cells(grid, look, item, test) query_cells_reach(grid, look, (grid)->reach, item, test)
+
+#define query_cells_reach(grid, look, reach, item, test) do { \
+    int *start_ = (grid)->start.data; \
+    int x0_ = clamp_cell((look).x - (reach), (grid)->bounds.x, (grid)->cell_size, (grid)->cols); \
+    int x1_ = clamp_cell((look).x + (look).width + (reach), (grid)->bounds.x, (grid)->cell_size, (grid)->cols); \
+    int y0_ = clamp_cell((look).y - (reach), (grid)->bounds.y, (grid)->cell_size, (grid)->rows); \
+    int y1_ = clamp_cell((look).y + (look).height + (reach), (grid)->bounds.y, (grid)->cell_size, (grid)->rows); \
+    vec_clear(&(grid)->found); \
+    for (int y_ = y0_; y_ <= y1_; y_++) { \
+        int last_ = start_[y_ * (grid)->cols + x1_ + 1]; \
+        for (int i_ = start_[y_ * (grid)->cols + x0_]; i_ < last_; i_++) { \
+            item = &(grid)->items.data[i_]; \
+            if (test) { \
+                vec_push(&(grid)->found, item->ref); \
+            } \
+        } \
+    } \
+} while (0)
+
+SpatialRef *SpatialQuery(SpatialGrid *grid, Rectangle area, int *count) {
+    SpatialEntry *item;
+
+    query_cells(grid, area, item, CheckCollisionRecs(area, item->box));
+    *count = grid->found.length;
+    return grid->found.data;
+}
+
+SpatialRef *SpatialQueryCircle(SpatialGrid *grid, Vector2 centre, float radius, int *count) {
+    Rectangle bounds = { centre.x - radius, centre.y - radius, 2 * radius, 2 * radius };
+    SpatialEntry *item;
+
+    query_cells(grid, bounds, item, CheckCollisionCircleRec(centre, radius, item->box));
+    *count = grid->found.length;
+    return grid->found.data;
+}
+
+/* the centre of each box is in the cell it's filed under, so nothing
+   further out than radius can be near, however big it is */
+SpatialRef *SpatialQueryNear(SpatialGrid *grid, Vector2 centre, float radius, int *count) {
+    Rectangle bounds = { centre.x - radius, centre.y - radius, 2 * radius, 2 * radius };
+    SpatialEntry *item;
+    float dx, dy;
+
+    query_cells_reach(grid, bounds, 0, item, (
+        dx = item->box.x + item->box.width / 2 - centre.x,
+        dy = item->box.y + item->box.height / 2 - centre.y,
+        dx * dx + dy * dy < radius * radius
+    ));
+    *count = grid->found.length;
+    return grid->found.data;
+}
+
+/* box (as its circumcircle) against the slice of the circle around centre */
+static bool sector_overlaps(Vector2 centre, float radius, float angle, float half_arc, Rectangle box) {
+    float dx = box.x + box.width / 2 - centre.x;
+    float dy = box.y + box.height / 2 - centre.y;
+    float r = sqrtf(box.width * box.width + box.height * box.height) / 2;
+    float dist = sqrtf(dx * dx + dy * dy);
+    float off;
+
+    if (dist > radius + r) {
+        return false;
+    }
+    if (dist <= r) {
+        return true;
+    }
+    /* how far off the middle of the slice it is, -pi to pi */
+    off = remainderf(atan2f(dy, dx) - angle, 2 * PI);
+    return fabsf(off) <= half_arc + asinf(r / dist);
+}
+
+/* smallest box around the slice: the centre, both ends of the arc, and
+   wherever the arc crosses an axis */
+static Rectangle sector_bounds(Vector2 centre, float radius, float angle, float half_arc) {
+    float x0 = centre.x, x1 = centre.x, y0 = centre.y, y1 = centre.y;
+    float a, px, py;
+
+    if (half_arc >= PI) {
+        return (Rectangle){ centre.x - radius, centre.y - radius, 2 * radius, 2 * radius };
+    }
+    for (int i = -1; i <= 4; i++) {
+        if (i < 0 || i == 4) {
+            a = angle + (i < 0 ? -half_arc : half_arc);
+        } else {
+            a = i * PI / 2;
+            if (fabsf(remainderf(a - angle, 2 * PI)) > half_arc) {
+                continue;
+            }
+        }
+        px = centre.x + radius * cosf(a);
+        py = centre.y + radius * sinf(a);
+        x0 = fminf(x0, px); x1 = fmaxf(x1, px);
+        y0 = fminf(y0, py); y1 = fmaxf(y1, py);
+    }
+    return (Rectangle){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+SpatialRef *SpatialQuerySector(SpatialGrid *grid, Vector2 centre, float radius, float angle, float half_arc, int *count) {
+    Rectangle bounds = sector_bounds(centre, radius, angle, half_arc);
+    SpatialEntry *item;
+
+    query_cells(grid, bounds, item, sector_overlaps(centre, radius, angle, half_arc, item->box));
+    *count = grid->found.length;
+    return grid->found.data;
+}
+
+/* narrows [tmin, tmax] to when o + t * d is inside [lo, hi] */
+static bool clip_slab(float o, float d, float lo, float hi, float *tmin, float *tmax) {
+    float t0, t1, swap;
+
+    if (fabsf(d) < 1e-6f) {
+        return o >= lo && o <= hi;
+    }
+    t0 = (lo - o) / d;
+    t1 = (hi - o) / d;
+    if (t0 > t1) {
+        swap = t0; t0 = t1; t1 = swap;
+    }
+    *tmin = fmaxf(*tmin, t0);
+    *tmax = fminf(*tmax, t1);
+    return *tmin <= *tmax;
+}
+
+bool SweepRects(Rectangle box, Vector2 motion, Rectangle target, float *t) {
+    /* grow the target by half the box and sweep the box's centre instead */
+    float hw = box.width / 2, hh = box.height / 2;
+    float tmin = 0, tmax = 1;
+
+    if (!clip_slab(box.x + hw, motion.x, target.x - hw, target.x + target.width + hw, &tmin, &tmax)
+        || !clip_slab(box.y + hh, motion.y, target.y - hh, target.y + target.height + hh, &tmin, &tmax)) {
+        return false;
+    }
+    *t = tmin;
+    return true;
+}
+
+Rectangle SweptBounds(Rectangle box, Vector2 motion) {
+    return (Rectangle){
+        box.x + fminf(0, motion.x),
+        box.y + fminf(0, motion.y),
+        box.width + fabsf(motion.x),
+        box.height + fabsf(motion.y),
+    };
+}
@@ -0,0 +1,78 @@
+#ifndef _SPATIAL_H_
+#define _SPATIAL_H_
+
+#include <stdbool.h>
+
+#include "raylib.h"
+#include "vec.h"
+
+/*
+    uniform grid broadphase, rebuilt from scratch every tick.
+
+    things are filed under the cell their centre is in, and queries grow
+    the area they look at by the biggest half size that was added (reach),
+    then test each box in those cells against the exact shape. what comes
+    back is everything whose box overlaps it.
+
+    the grid only covers bounds, anything outside is filed in the nearest
+    edge cell (and queries outside look there too), so it's never wrong,
+    just slower for things far off.
+
+    building is a counting sort: SpatialAdd notes the cell, EndSpatialGrid
+    lays every cell out contiguously in items.
+*/
+
+/* where to find the thing, game->entities[type].data[index] */
+typedef struct {
+    int type;
+    int index;
+} SpatialRef;
+
+typedef struct {
+    SpatialRef ref;
+    Rectangle box;
+    int cell;
+} SpatialEntry;
+
+typedef vec_t(SpatialRef) SpatialRefVec;
+typedef vec_t(SpatialEntry) SpatialEntryVec;
+
+typedef struct {
+    float cell_size;
+    Rectangle bounds;
+    int cols, rows;
+    /* biggest half width or height of anything added */
+    float reach;
+    /* in the order they were added, until EndSpatialGrid */
+    SpatialEntryVec added;
+    /* cell c is items[start[c] .. start[c + 1]) */
+    vec_int_t start;
+    SpatialEntryVec items;
+    /* what the last query found */
+    SpatialRefVec found;
+} SpatialGrid;
+
+/* capacity is the most things it'll hold, reserved up front */
+void InitSpatialGrid(SpatialGrid*, float cell_size, int capacity);
+void FreeSpatialGrid(SpatialGrid*);
+
+void BeginSpatialGrid(SpatialGrid*, Rectangle bounds);
+void SpatialAdd(SpatialGrid*, SpatialRef, Rectangle box);
+void EndSpatialGrid(SpatialGrid*);
+
+/* everything whose box overlaps the shape, valid until the next query */
+SpatialRef *SpatialQuery(SpatialGrid*, Rectangle area, int *count);
+SpatialRef *SpatialQueryCircle(SpatialGrid*, Vector2 centre, float radius, int *count);
+/* slice of a circle, angle is where it points and half_arc how far it
+   opens to each side (radians). boxes are treated as their circumcircle */
+SpatialRef *SpatialQuerySector(SpatialGrid*, Vector2 centre, float radius, float angle, float half_arc, int *count);
+/* everything whose box's centre is closer than radius, same lifetime */
+SpatialRef *SpatialQueryNear(SpatialGrid*, Vector2 centre, float radius, int *count);
+
+/* box moving by motion against a still target. true if they touch on
+   the way, t is how far along motion (0-1) that first happens */
+bool SweepRects(Rectangle box, Vector2 motion, Rectangle target, float *t);
+/* the area a box covers while it moves by motion */
+Rectangle SweptBounds(Rectangle box, Vector2 motion);
+
+#endif /* _SPATIAL_H_ */
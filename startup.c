@@ -0,0 +1,108 @@
+#include "startup.h"
+
+#include <stdio.h>      /* fopen, fprintf, printf */
+#include <string.h>     /* strchr, strrchr */
+#include <time.h>       /* time */
+#include <unistd.h>     /* sysconf */
+
+#include "timer.h"
+
+typedef struct {
+    const char *step;
+    /* ClockSeconds when it finished */
+    double at;
+} StartupStep;
+
+static struct {
+    bool enabled, reported;
+    /* ClockSeconds of exec, or of EnableStartupProfile if we can't tell */
+    double process_start;
+    bool from_exec;
+    StartupStep steps[STARTUP_MAX_MARKS];
+    int count;
+} profile;
+
+/* how long ago the process was started, from field 22 of /proc/self/stat.
+   only as fine as the clock tick (10 ms usually). -1 if unavailable */
+static double process_age(void) {
+    unsigned long long start_ticks;
+    struct timespec boot;
+    char buf[1024], *p;
+    size_t n;
+    FILE *f;
+
+    if ((f = fopen("/proc/self/stat", "r")) == NULL) {
+        return -1;
+    }
+    n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    /* the name in field 2 can hold spaces, so count from the last ')' */
+    if ((p = strrchr(buf, ')')) == NULL) {
+        return -1;
+    }
+    for (int field = 2; field < 22 && p != NULL; field++) {
+        p = strchr(p + 1, ' ');
+    }
+    if (p == NULL || sscanf(p, " %llu", &start_ticks) != 1) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    return boot.tv_sec + boot.tv_nsec / 1e9 - (double) start_ticks / sysconf(_SC_CLK_TCK);
+}
+
+void EnableStartupProfile(void) {
+    double now = ClockSeconds(), age = process_age();
+
+    profile.enabled = true;
+    profile.from_exec = age >= 0;
+    profile.process_start = profile.from_exec ? now - age : now;
+    StartupMark("exec to main");
+}
+
+bool StartupProfileEnabled(void) {
+    return profile.enabled;
+}
+
+void StartupMark(const char *step) {
+    if (!profile.enabled || profile.reported || profile.count == STARTUP_MAX_MARKS) {
+        return;
+    }
+    profile.steps[profile.count++] = (StartupStep){ step, ClockSeconds() };
+}
+
+void ReportStartupProfile(void) {
+    double prev = profile.process_start, ms;
+    FILE *f;
+
+    if (!profile.enabled || profile.reported) {
+        return;
+    }
+    profile.reported = true;
+
+    printf("startup profile (ms since %s):\n", profile.from_exec ? "exec" : "main");
+    printf("%-24s %10s %10s\n", "step", "took", "at");
+    for (int i = 0; i < profile.count; i++) {
+        printf("%-24s %10.2f %10.2f\n", profile.steps[i].step,
+            (profile.steps[i].at - prev) * 1000, (profile.steps[i].at - profile.process_start) * 1000);
+        prev = profile.steps[i].at;
+    }
+
+    if ((f = fopen(STARTUP_PROFILE_PATH, "a")) == NULL) {
+        fprintf(stderr, "Could not write %s\n", STARTUP_PROFILE_PATH);
+        return;
+    }
+    fprintf(f, "{\"time\": %ld, \"since\": \"%s\", \"steps\": [", (long) time(NULL), profile.from_exec ? "exec" : "main");
+    prev = profile.process_start;
+    for (int i = 0; i < profile.count; i++) {
+        ms = (profile.steps[i].at - prev) * 1000;
+        fprintf(f, "%s{\"step\": \"%s\", \"ms\": %.3f, \"at_ms\": %.3f}", i > 0 ? ", " : "",
+            profile.steps[i].step, ms, (profile.steps[i].at - profile.process_start) * 1000);
+        prev = profile.steps[i].at;
+    }
+    fprintf(f, "], \"total_ms\": %.3f}\n", (prev - profile.process_start) * 1000);
+    fclose(f);
+    printf("written to %s\n", STARTUP_PROFILE_PATH);
+}
@@ -0,0 +1,30 @@
+#ifndef _STARTUP_H_
+#define _STARTUP_H_
+
+#include <stdbool.h>
+
+/*
+    --profile-startup: times each step of getting to the first frame,
+    measured from when the process was started (exec, from /proc, so
+    dynamic linking and everything before main counts too).
+
+    prints a breakdown once the first frame is up and the assets are in,
+    and appends it as one JSON object per line to STARTUP_PROFILE_PATH so
+    runs can be compared over time (the first run after a reboot or a
+    rebuild is the cold one).
+
+    it's process wide and main thread only, marks are no-ops unless it
+    was enabled.
+*/
+
+#define STARTUP_PROFILE_PATH "./startup_profile.jsonl"
+#define STARTUP_MAX_MARKS 16
+
+void EnableStartupProfile(void);
+bool StartupProfileEnabled(void);
+/* the time since the last mark goes to step */
+void StartupMark(const char *step);
+/* prints and writes it out, only the first call does anything */
+void ReportStartupProfile(void);
+
+#endif /* _STARTUP_H_ */
@@ -0,0 +1,242 @@
+#include "status.h"
+#include "game.h"
+
+void InitStatus(Game *game) {
+    StatusList *l;
+    int capacity = 0;
+
+    for (int i = 0; i < len(game->config.enemy_types); i++) {
+        capacity += game->config.entitydata[game->config.enemy_types[i]].max_count;
+    }
+    capacity = capacity < STATUS_MAX_ENTRIES ? capacity : STATUS_MAX_ENTRIES;
+
+    for (int s = 0; s < STATUS_COUNT; s++) {
+        l = &game->status[s];
+        *l = (StatusList){ .capacity = capacity };
+        // one block each, the entries then heap then at
+        l->entries = MemAlloc(capacity * (sizeof(StatusEntry) + 2 * sizeof(int)));
+        l->heap = (int *) (l->entries + capacity);
+        l->at = l->heap + capacity;
+    }
+}
+
+void FreeStatus(Game *game) {
+    for (int s = 0; s < STATUS_COUNT; s++) {
+        MemFree(game->status[s].entries);
+        game->status[s] = (StatusList){0};
+    }
+}
+
+void ClearStatus(Game *game) {
+    for (int s = 0; s < STATUS_COUNT; s++) {
+        game->status[s].count = 0;
+    }
+}
+
+/* gametime in whole ticks, which is what expires is in */
+static int status_tick(Game *game) {
+    return lroundf(game->ui.gametime * game->config.target_fps);
+}
+
+static Entity *enemy_of(Game *game, StatusEntry *entry) {
+    return &game->entities[entry->enemy.type].data[entry->enemy.index];
+}
+
+/* the heap. a and b are places in it, not slots */
+
+static bool runs_out_first(StatusList *l, int a, int b) {
+    return l->entries[l->heap[a]].expires < l->entries[l->heap[b]].expires;
+}
+
+static void heap_swap(StatusList *l, int a, int b) {
+    int slot = l->heap[a];
+
+    l->heap[a] = l->heap[b];
+    l->heap[b] = slot;
+    l->at[l->heap[a]] = a;
+    l->at[l->heap[b]] = b;
+}
+
+static void sift_up(StatusList *l, int i) {
+    while (i > 0 && runs_out_first(l, i, (i - 1) / 2)) {
+        heap_swap(l, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void sift_down(StatusList *l, int i) {
+    int child;
+
+    while ((child = 2 * i + 1) < l->count) {
+        if (child + 1 < l->count && runs_out_first(l, child + 1, child)) {
+            child++;
+        }
+        if (!runs_out_first(l, child, i)) {
+            break;
+        }
+        heap_swap(l, i, child);
+        i = child;
+    }
+}
+
+void RebuildStatus(Game *game, StatusEffect s) {
+    StatusList *l = &game->status[s];
+
+    for (int slot = 0; slot < l->count; slot++) {
+        l->heap[slot] = slot;
+        l->at[slot] = slot;
+    }
+    for (int i = l->count / 2 - 1; i >= 0; i--) {
+        sift_down(l, i);
+    }
+}
+
+/* takes slot out of the heap, then fills it with the last entry. the
+   enemy it was on no longer has it, the one that moved is told where */
+static void remove_entry(Game *game, StatusEffect s, int slot) {
+    StatusList *l = &game->status[s];
+    int place = l->at[slot], moved;
+
+    enemy_of(game, &l->entries[slot])->status[s] = 0;
+
+    heap_swap(l, place, l->count - 1);
+    l->count--;
+    if (place < l->count) {
+        // whatever came up from the bottom could belong either way
+        moved = l->heap[place];
+        sift_up(l, place);
+        if (l->at[moved] == place) {
+            sift_down(l, place);
+        }
+    }
+
+    if (slot < l->count) {
+        l->entries[slot] = l->entries[l->count];
+        l->at[slot] = l->at[l->count];
+        l->heap[l->at[slot]] = slot;
+        enemy_of(game, &l->entries[slot])->status[s] = slot + 1;
+    }
+}
+
+void InflictStatus(Game *game, Entity *e, unsigned int effects) {
+    int tick = status_tick(game), slot;
+    StatusConfig *c;
+    StatusList *l;
+    StatusEntry *entry;
+
+    if (effects == 0 || e->hp <= 0) {
+        return;
+    }
+    for (int s = 0; s < STATUS_COUNT; s++) {
+        if (!(effects & STATUS_BIT(s))) {
+            continue;
+        }
+        c = &game->config.status[s];
+        l = &game->status[s];
+
+        // already has it, it only lasts longer (and maybe hurts more)
+        if (e->status[s] > 0) {
+            slot = e->status[s] - 1;
+            entry = &l->entries[slot];
+            entry->expires = tick + lroundf(c->duration * game->config.target_fps);
+            entry->stacks = entry->stacks < c->max_stacks ? entry->stacks + 1 : c->max_stacks;
+            sift_down(l, l->at[slot]);
+            continue;
+        }
+        // every enemy fits, this is just in case
+        if (l->count >= l->capacity) {
+            continue;
+        }
+        slot = l->count++;
+        l->entries[slot] = (StatusEntry){
+            .enemy = { e->type, e - game->entities[e->type].data },
+            .expires = tick + lroundf(c->duration * game->config.target_fps),
+            .stacks = 1,
+            .speed = e->speed,
+        };
+        l->heap[slot] = slot;
+        l->at[slot] = slot;
+        sift_up(l, slot);
+        e->status[s] = slot + 1;
+        if (c->slow > 0) {
+            e->speed *= c->slow;
+        }
+    }
+}
+
+void ForgetStatus(Game *game, int type, int index) {
+    EntityVec *ev = &game->entities[type];
+    Entity *last = &ev->data[ev->length - 1];
+
+    for (int s = 0; s < STATUS_COUNT; s++) {
+        if (ev->data[index].status[s] > 0) {
+            remove_entry(game, s, ev->data[index].status[s] - 1);
+        }
+        // vec_remove moves the last one into index
+        if (last->status[s] > 0) {
+            game->status[s].entries[last->status[s] - 1].enemy.index = index;
+        }
+    }
+}
+
+/* everything whose time is up, soonest first. speed comes back as it was */
+static void expire_status(Game *game, StatusEffect s, int tick) {
+    StatusList *l = &game->status[s];
+    float slow = game->config.status[s].slow;
+    int slot;
+
+    while (l->count > 0 && l->entries[l->heap[0]].expires <= tick) {
+        slot = l->heap[0];
+        if (slow > 0) {
+            enemy_of(game, &l->entries[slot])->speed = l->entries[slot].speed;
+        }
+        remove_entry(game, s, slot);
+    }
+}
+
+/* every interval, straight down the list. kills are only marked, same as
+   everything else that does damage */
+static void hurt_status(Game *game, StatusEffect s, int tick) {
+    StatusList *l = &game->status[s];
+    StatusConfig *c = &game->config.status[s];
+    int every = lroundf(c->interval * game->config.target_fps);
+    StatusEntry *entry;
+    Entity *e;
+
+    if (c->damage <= 0 || every <= 0 || tick % every != 0) {
+        return;
+    }
+    for (int i = 0; i < l->count; i++) {
+        entry = &l->entries[i];
+        e = enemy_of(game, entry);
+        if (e->hp > 0) {
+            DamageEnemy(game, e, c->damage * entry->stacks);
+        }
+    }
+}
+
+void UpdateStatus(Game *game) {
+    int tick = status_tick(game);
+
+    for (int s = 0; s < STATUS_COUNT; s++) {
+        expire_status(game, s, tick);
+        hurt_status(game, s, tick);
+    }
+}
+
+/* a ring around each one per effect, a size apart so they all show */
+void DrawStatus(Game *game) {
+    Rectangle view = screen_view(game);
+    StatusList *l;
+    Entity *e;
+
+    for (int s = 0; s < STATUS_COUNT; s++) {
+        l = &game->status[s];
+        for (int i = 0; i < l->count; i++) {
+            e = enemy_of(game, &l->entries[i]);
+            if (CheckCollisionPointRec((Vector2){ e->x, e->y }, view)) {
+                DrawCircleLines(e->x, e->y, e->size + 2 * (s + 1), game->config.status[s].colour);
+            }
+        }
+    }
+}
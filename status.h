@@ -0,0 +1,93 @@
+#ifndef _STATUS_H_
+#define _STATUS_H_
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+#include "spatial.h"
+
+/*
+    status effects on enemies: burning, frozen, poisoned.
+
+    enemies don't check for them in their update, each effect keeps its
+    own list of who has it instead. burn and poison damage is one pass
+    down that list every interval, however many there are and whatever
+    type they are. an enemy only knows where it is in each list
+    (Entity.status), so applying an effect again finds its entry straight
+    away.
+
+    when they run out is kept in a min-heap per effect, soonest first, so
+    each tick only looks at the ones running out then and nothing else.
+
+    entries point at their enemy by index, so whatever takes an enemy out
+    of its vec has to go through ForgetStatus first (see RemoveEntity).
+    both the lists and the vecs fill holes by moving the last one in, and
+    the back pointers are fixed up each time.
+*/
+
+typedef enum {
+    STATUS_BURN = 0,
+    STATUS_FROZEN,
+    STATUS_POISON,
+    /* how many there are */
+    STATUS_COUNT,
+} StatusEffect;
+
+/* for EntityAttrs.inflicts and ParticleAttrs.inflicts */
+#define STATUS_BIT(effect) (1u << (effect))
+/* Entity.status is a slot + 1 in an unsigned short */
+#define STATUS_MAX_ENTRIES 65535
+
+typedef struct Game Game;
+typedef struct Entity Entity;
+
+typedef struct {
+    /* seconds from the last time it was applied */
+    float duration;
+    /* burn and poison: seconds between hits, and damage per hit per stack */
+    float interval;
+    int damage;
+    /* frozen: times its speed while it lasts */
+    float slow;
+    /* applying it again while it's on adds a stack, up to this many */
+    int max_stacks;
+    Color colour;
+} StatusConfig;
+
+typedef struct {
+    /* which enemy, the index is kept up to date as it moves */
+    SpatialRef enemy;
+    /* tick it runs out on */
+    int expires;
+    int stacks;
+    /* frozen: its speed from before */
+    float speed;
+} StatusEntry;
+
+typedef struct {
+    int count, capacity;
+    StatusEntry *entries;
+    /* slots into entries, soonest expires first. at[slot] is where in
+       heap that slot is */
+    int *heap, *at;
+} StatusList;
+
+/* after ReserveStorage, the lists are as big as every enemy there can be */
+void InitStatus(Game*);
+void FreeStatus(Game*);
+/* only when the enemy vecs are being cleared too */
+void ClearStatus(Game*);
+/* LoadSnapshot: the entries are in, this puts the heap back together */
+void RebuildStatus(Game*, StatusEffect);
+
+/* effects is a mask of STATUS_BITs */
+void InflictStatus(Game*, Entity*, unsigned int effects);
+/* game->entities[type].data[index] is about to be vec_removed */
+void ForgetStatus(Game*, int type, int index);
+/* after the damage for the tick is done, before dead enemies are removed */
+void UpdateStatus(Game*);
+/* after the enemies */
+void DrawStatus(Game*);
+
+#endif /* _STATUS_H_ */
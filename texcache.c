@@ -0,0 +1,130 @@
+#include "texcache.h"
+
+#include <stdio.h>      /* fprintf */
+#include <string.h>     /* strncmp, strncpy */
+
+TextureCache *NewTextureCache(AssetLoader *loader, size_t budget) {
+    TextureCache *c = MemAlloc(sizeof(TextureCache));
+    c->loader = loader;
+    c->budget = budget;
+    vec_init(&c->entries);
+    return c;
+}
+
+static void unload(CachedTexture *e) {
+    if (e->texture.loaded) {
+        UnloadTexture(e->texture.data);
+        e->texture.data = (Texture2D){0};
+        e->texture.loaded = false;
+    }
+    e->bytes = 0;
+}
+
+void FreeTextureCache(TextureCache *c) {
+    if (c == NULL) {
+        return;
+    }
+    for (int i = 0; i < c->entries.length; i++) {
+        unload(c->entries.data[i]);
+        MemFree(c->entries.data[i]);
+    }
+    vec_deinit(&c->entries);
+    MemFree(c);
+}
+
+CachedTexture *AcquireTexture(TextureCache *c, const char *path) {
+    CachedTexture *e;
+
+    for (int i = 0; i < c->entries.length; i++) {
+        e = c->entries.data[i];
+        if (strncmp(e->path, path, ASSET_NAME_MAX) == 0) {
+            e->refs++;
+            return e;
+        }
+    }
+
+    e = MemAlloc(sizeof(CachedTexture));
+    strncpy(e->path, path, ASSET_NAME_MAX - 1);
+    e->texture.filepath = e->path;
+    e->refs = 1;
+    vec_push(&c->entries, e);
+    return e;
+}
+
+void ReleaseTexture(TextureCache *c, CachedTexture *e) {
+    (void) c;
+    if (e != NULL && e->refs > 0) {
+        e->refs--;
+    }
+}
+
+void PrefetchTexture(TextureCache *c, CachedTexture *e) {
+    if (!e->texture.loaded && !e->requested) {
+        RequestTexture(c->loader, &e->texture);
+        e->requested = true;
+    }
+}
+
+Texture2D *UseTexture(TextureCache *c, CachedTexture *e) {
+    e->last_used = c->frame;
+    if (e->texture.loaded) {
+        c->stats.hits++;
+        return &e->texture.data;
+    }
+    c->stats.misses++;
+    PrefetchTexture(c, e);
+    return NULL;
+}
+
+/* least recently used loaded entry, NULL if there's nothing to give up */
+static CachedTexture *eviction_candidate(TextureCache *c) {
+    CachedTexture *e, *best = NULL;
+
+    /* never one somebody holds: idle and paused frames don't draw anything,
+       so "not drawn this frame" would take the background out from under
+       GameplayAssetsReady, and nothing would ever ask for it again */
+    for (int i = 0; i < c->entries.length; i++) {
+        e = c->entries.data[i];
+        if (!e->texture.loaded || e->last_used == c->frame || e->refs > 0) {
+            continue;
+        }
+        if (best == NULL || e->last_used < best->last_used) {
+            best = e;
+        }
+    }
+    return best;
+}
+
+void TrimTextureCache(TextureCache *c) {
+    CachedTexture *e;
+
+    if (c == NULL) {
+        return;
+    }
+
+    c->stats.count = 0;
+    c->stats.bytes = 0;
+    for (int i = 0; i < c->entries.length; i++) {
+        e = c->entries.data[i];
+        if (!e->texture.loaded) {
+            continue;
+        }
+        /* just landed */
+        if (e->requested) {
+            e->requested = false;
+            e->bytes = GetPixelDataSize(e->texture.data.width, e->texture.data.height, e->texture.data.format);
+            c->stats.uploads++;
+        }
+        c->stats.count++;
+        c->stats.bytes += e->bytes;
+    }
+
+    while (c->stats.bytes > c->budget && (e = eviction_candidate(c)) != NULL) {
+        c->stats.count--;
+        c->stats.bytes -= e->bytes;
+        c->stats.evictions++;
+        unload(e);
+    }
+
+    c->frame++;
+}
@@ -0,0 +1,68 @@
+#ifndef _TEXCACHE_H_
+#define _TEXCACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "assets.h"
+
+/*
+    texture registry keyed by path.
+
+    AcquireTexture hands out an entry and counts the reference, nothing is
+    loaded until the first UseTexture (or PrefetchTexture), which asks the
+    AssetLoader for it. until the upload lands UseTexture returns NULL and
+    the caller just doesn't draw it.
+
+    once per frame TrimTextureCache adds up what's on the GPU and, while
+    that's over budget, unloads the least recently used texture that
+    nobody holds a reference to. referenced ones stay however far over
+    budget that leaves it. an evicted texture comes back on its next use.
+*/
+
+typedef struct {
+    char path[ASSET_NAME_MAX];
+    /* what the loader fills in, texture.filepath points at path */
+    GameTexture texture;
+    int refs;
+    /* asked the loader for it and it hasn't landed yet */
+    bool requested;
+    /* decoded size, 0 until it's loaded */
+    size_t bytes;
+    /* TextureCache.frame when it was last drawn */
+    uint64_t last_used;
+} CachedTexture;
+
+typedef struct {
+    int hits, misses;
+    int uploads, evictions;
+    int count;
+    size_t bytes;
+} TextureCacheStats;
+
+typedef struct {
+    AssetLoader *loader;
+    /* pointers so entries never move, the loader holds on to them */
+    vec_t(CachedTexture*) entries;
+    size_t budget;
+    uint64_t frame;
+    TextureCacheStats stats;
+} TextureCache;
+
+TextureCache *NewTextureCache(AssetLoader*, size_t budget);
+/* call after the loader has stopped, unloads everything */
+void FreeTextureCache(TextureCache*);
+
+CachedTexture *AcquireTexture(TextureCache*, const char *path);
+void ReleaseTexture(TextureCache*, CachedTexture*);
+
+/* NULL until it's on the GPU, starts loading it if it isn't */
+Texture2D *UseTexture(TextureCache*, CachedTexture*);
+/* start loading without counting a use */
+void PrefetchTexture(TextureCache*, CachedTexture*);
+
+/* once per frame, after PumpAssetUploads */
+void TrimTextureCache(TextureCache*);
+
+#endif /* _TEXCACHE_H_ */
@@ -1,22 +1,36 @@
 #include "timer.h"
 
-/* returns true if an interval has passed, then resets the interval */
-bool TimeIntervalPassed(Timer *t) {
-    float new_time = GetTime();
-    if (new_time - t->last_recorded >= t->interval) {
-        t->last_recorded = new_time;
-        return true;
+#include <time.h>       /* clock_gettime */
+
+/* returns how many whole intervals have passed and moves last_recorded
+   forward by that many, so the leftover carries into the next one instead
+   of being lost. now comes from the owner's clock, not GetTime, so paused
+   or headless games keep their own time */
+int TimeIntervalsPassed(Timer *t, float now) {
+    int count;
+
+    if (t->interval <= 0 || now - t->last_recorded < t->interval) {
+        return 0;
     }
-    return false;
+    count = (int) ((now - t->last_recorded) / t->interval);
+    t->last_recorded += count * t->interval;
+    return count;
 }
 
-/* calls the callback if needed */
-void CheckTimer(Timer *t) {
-    if (TimeIntervalPassed(t)) {
-        t->callback(); 
+/* calls the callback once for however many intervals passed */
+void CheckTimer(Timer *t, float now, void *ctx) {
+    int count = TimeIntervalsPassed(t, now);
+    if (count > 0) {
+        t->callback(ctx, count, now - t->last_recorded);
     }
 }
 
 void ResetTimer(Timer *t) {
     t->last_recorded = 0;
 }
+
+double ClockSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
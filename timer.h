@@ -3,7 +3,11 @@
 
 #include "raylib.h"
 
-typedef void (*TimerCallback)(void);
+/* ctx is whatever was passed to CheckTimer. count is how many intervals
+   passed since the last call (more than 1 if the interval is shorter than
+   a tick), late is how long ago the newest of them was due. the one
+   before it was due late + interval ago, and so on */
+typedef void (*TimerCallback)(void *ctx, int count, float late);
 
 typedef struct {
   float interval;
@@ -19,8 +23,11 @@ typedef struct {
   }                                     
 
 
-bool TimeIntervalPassed(Timer*);
-void CheckTimer(Timer*);
+int TimeIntervalsPassed(Timer*, float now);
+void CheckTimer(Timer*, float now, void *ctx);
 void ResetTimer(Timer*); 
 
+/* wall clock in seconds, monotonic - for measuring, not for gameplay */
+double ClockSeconds(void);
+
 #endif
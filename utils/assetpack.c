@@ -0,0 +1,133 @@
+/*
+    packs every image under a directory into one archive of decoded pixels,
+    see assets.h for the layout.
+
+    usage: assetpack <asset dir> <output>
+
+    run from the repo root (make pack) so the names match the paths the
+    game loads, e.g. assets/background/bg_hextiles_large.png
+*/
+
+#include "../assets.h"
+#include "../vec.h"
+
+#include <dirent.h>     /* opendir, readdir */
+#include <stdio.h>      /* fopen, fwrite, printf */
+#include <string.h>     /* memcpy, strncpy */
+#include <sys/stat.h>   /* stat */
+
+typedef vec_t(AssetEntry) AssetEntryVec;
+typedef vec_t(Image) ImageVec;
+
+static bool packable(const char *path) {
+    return IsFileExtension(path, ".png;.jpg;.jpeg;.bmp;.tga;.gif");
+}
+
+/* decodes every image under dir, depth first in readdir order */
+static void collect(const char *dir, AssetEntryVec *entries, ImageVec *images) {
+    char path[ASSET_NAME_MAX];
+    struct dirent *d;
+    struct stat st;
+    AssetEntry e;
+    Image img;
+    DIR *dp;
+
+    if ((dp = opendir(dir)) == NULL) {
+        fprintf(stderr, "Could not open %s\n", dir);
+        return;
+    }
+
+    while ((d = readdir(dp)) != NULL) {
+        if (d->d_name[0] == '.') {
+            continue;
+        }
+        if (snprintf(path, sizeof(path), "%s/%s", dir, d->d_name) >= (int) sizeof(path)) {
+            fprintf(stderr, "Skipping, name too long: %s/%s\n", dir, d->d_name);
+            continue;
+        }
+        if (stat(path, &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            collect(path, entries, images);
+            continue;
+        }
+        if (!packable(path)) {
+            continue;
+        }
+
+        img = LoadImage(path);
+        if (img.data == NULL) {
+            fprintf(stderr, "Could not decode %s\n", path);
+            continue;
+        }
+
+        e = (AssetEntry){
+            .width = img.width,
+            .height = img.height,
+            .format = img.format,
+            .mipmaps = img.mipmaps,
+            .size = GetPixelDataSize(img.width, img.height, img.format),
+        };
+        strncpy(e.name, path, ASSET_NAME_MAX - 1);
+        vec_push(entries, e);
+        vec_push(images, img);
+    }
+    closedir(dp);
+}
+
+static uint64_t align_up(uint64_t n) {
+    return (n + ASSET_PACK_ALIGN - 1) & ~(uint64_t)(ASSET_PACK_ALIGN - 1);
+}
+
+int main(int argc, char **argv) {
+    static const char zeros[ASSET_PACK_ALIGN] = {0};
+    AssetPackHeader h = {0};
+    AssetEntryVec entries;
+    ImageVec images;
+    uint64_t pos;
+    FILE *f;
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <asset dir> <output>\n", argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_ERROR);
+    vec_init(&entries);
+    vec_init(&images);
+    collect(argv[1], &entries, &images);
+
+    memcpy(h.magic, ASSET_PACK_MAGIC, 4);
+    h.version = ASSET_PACK_VERSION;
+    h.count = entries.length;
+    h.entry_size = sizeof(AssetEntry);
+
+    /* lay out the blobs first so the index can be written in one go */
+    pos = align_up(sizeof(h) + (uint64_t) entries.length * sizeof(AssetEntry));
+    for (int i = 0; i < entries.length; i++) {
+        entries.data[i].offset = pos;
+        pos = align_up(pos + entries.data[i].size);
+    }
+
+    if ((f = fopen(argv[2], "wb")) == NULL) {
+        fprintf(stderr, "Could not write %s\n", argv[2]);
+        return 1;
+    }
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(entries.data, sizeof(AssetEntry), entries.length, f);
+    pos = sizeof(h) + (uint64_t) entries.length * sizeof(AssetEntry);
+    for (int i = 0; i < entries.length; i++) {
+        fwrite(zeros, 1, entries.data[i].offset - pos, f);
+        fwrite(images.data[i].data, 1, entries.data[i].size, f);
+        pos = entries.data[i].offset + entries.data[i].size;
+        printf("%s\t%dx%d\t%lu bytes\n", entries.data[i].name, entries.data[i].width, entries.data[i].height, (unsigned long) entries.data[i].size);
+        UnloadImage(images.data[i]);
+    }
+    fclose(f);
+
+    printf("%d assets, %lu bytes -> %s\n", entries.length, (unsigned long) pos, argv[2]);
+    vec_deinit(&entries);
+    vec_deinit(&images);
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+    dumps per-tick counts from a state stream written with --record,
+    one tab separated line per tick so it lines up with profiler output.
+
+    usage: streamdump <file> [first tick]
+
+    with a first tick it seeks straight to the chunk holding it
+*/
+
+#include "../record.h"
+
+static const char *entity_names[E_COUNT] = {
+    [E_ENEMY_BASIC] = "basic",
+    [E_ENEMY_LARGE] = "large",
+    [E_ENEMY_RANGED] = "ranged",
+    [E_PLAYER_BULLET] = "bullets",
+    [E_PLAYER_SHELL] = "shells",
+    [E_PLAYER_SPIKE] = "spikes",
+    [E_PLAYER_ARC] = "arcs",
+};
+
+typedef struct {
+    uint32_t tick;
+    int counts[E_COUNT];
+} DumpState;
+
+/* walks one tick record and prints it, false if the data is bad */
+static bool dump_tick(DumpState *s, const unsigned char **p, const unsigned char *end, bool keyframe, uint32_t first_tick) {
+    const unsigned char *start = *p;
+    uint32_t u, n, removed, spawned, skip, survivors;
+    int32_t v;
+    int total_spawned = 0, total_removed = 0, particles;
+
+    if (!get_uvarint(p, end, &u)) return false;
+    s->tick = keyframe ? u : s->tick + u;
+
+    /* player */
+    for (int i = 0; i < 3; i++) {
+        if (!get_svarint(p, end, &v)) return false;
+    }
+
+    for (int t = 0; t < E_COUNT; t++) {
+        if (keyframe) {
+            if (!get_uvarint(p, end, &n)) return false;
+            for (uint32_t i = 0; i < n * 4; i++) {
+                if (!get_uvarint(p, end, &u)) return false;
+            }
+            s->counts[t] = n;
+            continue;
+        }
+
+        if (!get_uvarint(p, end, &removed)) return false;
+        for (uint32_t i = 0; i < removed; i++) {
+            if (!get_uvarint(p, end, &u)) return false;
+        }
+        if (!get_uvarint(p, end, &spawned)) return false;
+        for (uint32_t i = 0; i < spawned * 4; i++) {
+            if (!get_uvarint(p, end, &u)) return false;
+        }
+
+        if (removed > (uint32_t) s->counts[t]) return false;
+        survivors = s->counts[t] - removed;
+        for (uint32_t i = 0; ; i++) {
+            if (!get_uvarint(p, end, &skip)) return false;
+            i += skip;
+            if (i >= survivors) break;
+            if (*p >= end) return false;
+            if (*(*p)++ == RECORD_RESIDUAL_ESCAPE) {
+                for (int k = 0; k < 3; k++) {
+                    if (!get_svarint(p, end, &v)) return false;
+                }
+            }
+        }
+
+        s->counts[t] = survivors + spawned;
+        total_spawned += spawned;
+        total_removed += removed;
+    }
+
+    if (!get_uvarint(p, end, &n)) return false;
+    particles = n;
+    for (uint32_t i = 0; i < n; i++) {
+        if (*p >= end) return false;
+        (*p)++;
+        if (!get_svarint(p, end, &v) || !get_svarint(p, end, &v)) return false;
+    }
+
+    if (s->tick >= first_tick) {
+        printf("%u\t%ld", s->tick, (long) (*p - start));
+        for (int t = 0; t < E_COUNT; t++) {
+            printf("\t%d", s->counts[t]);
+        }
+        printf("\t%d\t%d\t%d\n", total_spawned, total_removed, particles);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    RecFileHeader fh;
+    RecChunkHeader ch;
+    DumpState state = {0};
+    unsigned char *stored, *raw;
+    const unsigned char *p, *end;
+    uint32_t first_tick = 0;
+    int raw_size;
+    FILE *f;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file> [first tick]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2) {
+        first_tick = strtoul(argv[2], NULL, 10);
+    }
+    if ((f = fopen(argv[1], "rb")) == NULL) {
+        fprintf(stderr, "File not found: %s\n", argv[1]);
+        return 1;
+    }
+
+    if (fread(&fh, sizeof(fh), 1, f) != 1
+        || memcmp(fh.magic, RECORD_MAGIC, 4) != 0
+        || fh.version != RECORD_VERSION
+        || fh.entity_types != E_COUNT) {
+        fprintf(stderr, "Not a version %d stream: %s\n", RECORD_VERSION, argv[1]);
+        return 1;
+    }
+
+    printf("tick\tbytes");
+    for (int t = 0; t < E_COUNT; t++) {
+        printf("\t%s", entity_names[t]);
+    }
+    printf("\tspawned\tremoved\tparticles\n");
+
+    while (fread(&ch, sizeof(ch), 1, f) == 1) {
+        if (memcmp(ch.magic, RECORD_CHUNK_MAGIC, 4) != 0) {
+            fprintf(stderr, "Bad chunk at %ld\n", ftell(f) - (long) sizeof(ch));
+            return 1;
+        }
+
+        /* seeking: skip whole chunks without reading them */
+        if (ch.first_tick + ch.ticks <= first_tick) {
+            fseek(f, ch.stored_size, SEEK_CUR);
+            continue;
+        }
+
+        stored = MemAlloc(ch.stored_size);
+        if (fread(stored, 1, ch.stored_size, f) != ch.stored_size) {
+            fprintf(stderr, "Truncated chunk at tick %u\n", ch.first_tick);
+            MemFree(stored);
+            return 1;
+        }
+        if (ch.compressed) {
+            raw = DecompressData(stored, ch.stored_size, &raw_size);
+            MemFree(stored);
+        } else {
+            raw = stored;
+            raw_size = ch.stored_size;
+        }
+        if (raw == NULL || (uint32_t) raw_size != ch.raw_size) {
+            fprintf(stderr, "Could not unpack chunk at tick %u\n", ch.first_tick);
+            return 1;
+        }
+
+        p = raw;
+        end = raw + raw_size;
+        for (uint32_t i = 0; i < ch.ticks; i++) {
+            if (!dump_tick(&state, &p, end, i == 0, first_tick)) {
+                fprintf(stderr, "Corrupt tick after %u\n", state.tick);
+                return 1;
+            }
+        }
+        MemFree(raw);
+    }
+
+    fclose(f);
+    return 0;
+}
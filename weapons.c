@@ -0,0 +1,129 @@
+#include "weapons.h"
+#include "game.h"
+
+_Static_assert(MAX_WEAPONS + 2 <= 8, "SnapshotHeader.timers is too small for the weapons");
+
+void InitWeapons(Game *game) {
+    for (int i = 0; i < MAX_WEAPONS; i++) {
+        game->weapons[i] = (WeaponState){0};
+    }
+}
+
+/* which way a volley points, false if there's nothing to aim at */
+static bool weapon_aim(Game *game, WeaponDef *w, float *angle) {
+    Entity *target;
+
+    switch (w->aim) {
+        case AIM_NEAREST: {
+            if ((target = player_closest_enemy(game)) == NULL) {
+                return false;
+            }
+            *angle = entity_angle(game->player, *target);
+            return true;
+        }
+        case AIM_CURSOR:
+        default: {
+            *angle = vec_angle((Vector2){ game->player.x, game->player.y }, PlayerAim(game));
+            return true;
+        }
+    }
+}
+
+/* shot at angle, moved along as far as it'd have got in late seconds */
+static Entity weapon_shot(Game *game, WeaponDef *w, float angle, float late) {
+    Entity shot = NewProjectile(game, w->projectile, angle);
+    float ticks = late * game->config.target_fps;
+
+    shot.x += shot.vx * ticks;
+    shot.y += shot.vy * ticks;
+    return shot;
+}
+
+/* one volley from weapon into shots, late seconds after it was due.
+   returns how many there are, 0 if there was nothing to aim at */
+static int build_volley(Game *game, int weapon, float late, Entity *shots) {
+    WeaponDef *w = &game->config.weapons[weapon];
+    WeaponState *s = &game->weapons[weapon];
+    int count = w->count < WEAPON_MAX_SHOTS ? w->count : WEAPON_MAX_SHOTS;
+    float angle = 0, step;
+
+    if (count <= 0) {
+        return 0;
+    }
+
+    switch (w->pattern) {
+        case PATTERN_SPREAD: {
+            if (!weapon_aim(game, w, &angle)) {
+                return 0;
+            }
+            step = count > 1 ? w->spread * DEG2RAD / (count - 1) : 0;
+            angle -= step * (count - 1) / 2;
+            for (int i = 0; i < count; i++) {
+                shots[i] = weapon_shot(game, w, angle + i * step, late);
+            }
+            break;
+        }
+        case PATTERN_BURST: {
+            if (!weapon_aim(game, w, &angle)) {
+                return 0;
+            }
+            // the rest go out from burst_shots
+            s->burst_left = count - 1;
+            s->burst_angle = angle;
+            s->burst_next = game->ui.gametime - late + w->burst_gap;
+            shots[0] = weapon_shot(game, w, angle, late);
+            count = 1;
+            break;
+        }
+        case PATTERN_NOVA:
+        case PATTERN_SPIRAL: {
+            step = 2 * PI / count;
+            for (int i = 0; i < count; i++) {
+                shots[i] = weapon_shot(game, w, s->spin + i * step, late);
+            }
+            if (w->pattern == PATTERN_SPIRAL) {
+                s->spin = remainderf(s->spin + w->spin * DEG2RAD, 2 * PI);
+            }
+            break;
+        }
+    }
+    return count;
+}
+
+/* BURST: the shots still to go that were due by until, onto out */
+static void burst_shots(Game *game, int weapon, float until, EntityVec *out) {
+    WeaponDef *w = &game->config.weapons[weapon];
+    WeaponState *s = &game->weapons[weapon];
+
+    while (s->burst_left > 0 && until >= s->burst_next) {
+        vec_push(out, weapon_shot(game, w, s->burst_angle, game->ui.gametime - s->burst_next));
+        s->burst_left--;
+        s->burst_next += w->burst_gap;
+    }
+}
+
+/* everything a weapon owes goes in with one AddEntities, oldest first so
+   if the pool is full it's the newest that stay */
+void UpdateWeapons(Game *game) {
+    Timer *timers = game->timers.weapons;
+    EntityVec *volleys = &game->volleys;
+    float late;
+    int due;
+
+    for (int i = 0; i < MAX_WEAPONS; i++) {
+        vec_clear(volleys);
+
+        // each a whole interval later than the one before. a burst still
+        // going when the next volley starts gets to finish what was due
+        due = TimeIntervalsPassed(&timers[i], game->ui.gametime);
+        for (int k = due - 1; k >= 0; k--) {
+            late = game->ui.gametime - timers[i].last_recorded + k * game->config.weapons[i].interval;
+            burst_shots(game, i, game->ui.gametime - late, volleys);
+            vec_reserve(volleys, volleys->length + WEAPON_MAX_SHOTS);
+            volleys->length += build_volley(game, i, late, volleys->data + volleys->length);
+        }
+        burst_shots(game, i, game->ui.gametime, volleys);
+
+        AddEntities(game, volleys->data, volleys->length);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef _WEAPONS_H_
+#define _WEAPONS_H_
+
+/*
+    data-driven player weapons. a WeaponDef says what it shoots (an
+    EntityType, which has the speed, damage, pierce and so on), where it
+    aims, what shape the volley makes and how often it goes off.
+
+    patterns:
+    - SPREAD: count shots fanned evenly over spread degrees (1 = straight)
+    - BURST: count shots one after the other, burst_gap seconds apart
+    - NOVA: count shots evenly all the way round
+    - SPIRAL: a nova that turns by spin degrees every volley
+
+    every volley a weapon owes in a tick, catch-up ones and the rest of a
+    burst included, is built in a scratch vec (Game.volleys) and goes
+    into the projectile's pool with one AddEntities call. velocity is
+    worked out once here, the per-tick update never touches cos/sin.
+
+    the timers live in GameTimers.weapons so snapshots keep them.
+*/
+
+typedef struct Game Game;
+
+#define MAX_WEAPONS 6
+/* shots in one volley */
+#define WEAPON_MAX_SHOTS 64
+
+typedef enum {
+    PATTERN_SPREAD,
+    PATTERN_BURST,
+    PATTERN_NOVA,
+    PATTERN_SPIRAL,
+} WeaponPattern;
+
+typedef enum {
+    /* input.aim, the mouse or the bot */
+    AIM_CURSOR,
+    /* the closest enemy, holds fire if there isn't one */
+    AIM_NEAREST,
+} WeaponAim;
+
+typedef struct {
+    const char *name;
+    /* an EntityType */
+    int projectile;
+    WeaponPattern pattern;
+    WeaponAim aim;
+    /* seconds between volleys, 0 = empty slot */
+    float interval;
+    int count;
+    /* SPREAD: degrees the whole fan covers */
+    float spread;
+    /* BURST: seconds between shots */
+    float burst_gap;
+    /* SPIRAL: degrees it turns per volley */
+    float spin;
+} WeaponDef;
+
+typedef struct {
+    /* SPIRAL: where the next volley starts, radians */
+    float spin;
+    /* BURST: shots still to go, when the next is due (gametime) and
+       which way they're going */
+    int burst_left;
+    float burst_next, burst_angle;
+} WeaponState;
+
+void InitWeapons(Game*);
+/* fires whatever's due, call once per tick */
+void UpdateWeapons(Game*);
+
+#endif /* _WEAPONS_H_ */